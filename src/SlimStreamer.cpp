@@ -22,13 +22,18 @@
 #include <g3log/logworker.hpp>
 #include <iostream>
 #include <memory>
+#include <sched.h>
 #include <string>
 #include <tuple>
 #include <type_safe/optional.hpp>
+#include <type_safe/optional_ref.hpp>
 #include <vector>
 
+#include "slim/alsa/CaptureEngine.hpp"
 #include "slim/alsa/Parameters.hpp"
 #include "slim/alsa/Source.hpp"
+#include "slim/Chunk.hpp"
+#include "slim/conn/IOThreadPool.hpp"
 #include "slim/conn/tcp/Callbacks.hpp"
 #include "slim/conn/tcp/Server.hpp"
 #include "slim/conn/udp/Callbacks.hpp"
@@ -40,6 +45,7 @@
 #include "slim/EncoderBuilder.hpp"
 #include "slim/Exception.hpp"
 #include "slim/FileConsumer.hpp"
+#include "slim/flac/CompressionController.hpp"
 #include "slim/flac/Encoder.hpp"
 #include "slim/log/ConsoleSink.hpp"
 #include "slim/log/log.hpp"
@@ -47,6 +53,7 @@
 #include "slim/proto/OutboundCommand.hpp"
 #include "slim/proto/Streamer.hpp"
 #include "slim/Scheduler.hpp"
+#include "slim/util/RealTime.hpp"
 #include "slim/util/StreamAsyncWriter.hpp"
 #include "slim/util/Timestamp.hpp"
 #include "slim/wave/Encoder.hpp"
@@ -189,15 +196,25 @@ auto createProducers(conwrap2::ProcessorProxy<std::unique_ptr<ContainerBase>> pr
 	};
 
 	unsigned int                         chunkDurationMilliSecond{100};
+	std::size_t                          reservedChunks{4};
 	std::vector<std::unique_ptr<Source>> producers;
 
+	// all devices are captured by one thread
+	auto captureEnginePtr{std::make_shared<CaptureEngine>(parameters.getRealTimePriority(), parameters.getCPUAffinity())};
+
+	// only one stream is active at a time, so sources share chunk memory on top of a small reserve each
+	auto maxRate{std::get<0>(*std::max_element(rates.begin(), rates.end()))};
+	parameters.setFramesPerChunk((maxRate * chunkDurationMilliSecond) / 1000);
+	parameters.setReservedChunks(reservedChunks);
+	auto chunkArenaPtr{std::make_shared<Chunk::ArenaType>(parameters.getQueueSize() + rates.size() * reservedChunks, Source::getChunkSize(parameters))};
+
 	for (auto& [rate, device] : rates)
 	{
 		parameters.setSamplingRate(rate);
 		parameters.setDeviceName(device);
 		parameters.setFramesPerChunk((rate * chunkDurationMilliSecond) / 1000);
 
-		producers.push_back(std::make_unique<Source>(processorProxy, parameters, []
+		producers.push_back(std::make_unique<Source>(processorProxy, parameters, captureEnginePtr, chunkArenaPtr, []
 		{
 			LOG(ERROR) << LABELS{"slim"} << "Buffer overflow error: a chunk was skipped";
 		}));
@@ -247,12 +264,21 @@ int main(int argc, char *argv[])
 		options
 			.custom_help("[options]")
 			.add_options()
+				("a,affinity", "CPUs the capture thread is pinned to", cxxopts::value<std::vector<unsigned int>>(), "<cpu,...>")
+				("b,budget", "CPU budget for FLAC encoding in percent of real-time; compression level is adapted between streams (0 - minimal compression level is used)", cxxopts::value<unsigned int>()->default_value("0"), "<0-100>")
 				("c,maxclients", "Maximum amount of clients able to connect", cxxopts::value<int>()->default_value("10"), "<number>")
+				("e,encoderthreads", "Amount of encoding threads including one encoding worker thread; FLAC encoder uses the rest (0 - encoding is done by the main processing thread)", cxxopts::value<unsigned int>()->default_value("0"), "<number>")
 				("F,files", "Dump PCM to files", cxxopts::value<bool>())
 				("f,format", "Streaming format", cxxopts::value<std::string>()->default_value("FLAC"), "<PCM|FLAC>")
 				("g,gain", "Client audio gain", cxxopts::value<unsigned int>(), "<0-100>")
+				("H,history", "Amount of encoded chunks kept for slow clients; clients lagging further behind are disconnected", cxxopts::value<std::size_t>()->default_value("50"), "<number>")
 				("h,help", "Print this help message", cxxopts::value<bool>())
+				("L,lockmemory", "Lock process memory to prevent paging; memory is locked once it is used, so chunk memory which was never used stays available (the first use of a chunk may still page-fault)", cxxopts::value<bool>())
 				("l,license", "Print license details", cxxopts::value<bool>())
+				("m,mmap", "Capture PCM data using memory-mapped access", cxxopts::value<bool>())
+				("n,iothreads", "Amount of network I/O threads (0 - network I/O is handled by the main processing thread)", cxxopts::value<unsigned int>()->default_value("0"), "<number>")
+				("P,packed", "Stream PCM packed to 24 bits per sample (16 bits if PCM values fit into 16 bits)", cxxopts::value<bool>())
+				("p,priority", "Real-time (SCHED_FIFO) priority of the capture thread", cxxopts::value<int>(), "<1-99>")
 				("s,slimprotoport", "SlimProto (command connection) server port", cxxopts::value<int>()->default_value("3483"), "<port>")
 				("t,httpport", "HTTP (streaming connection) server port", cxxopts::value<int>()->default_value("9000"), "<port>")
 				("v,version", "Print version details", cxxopts::value<bool>());
@@ -276,10 +302,15 @@ int main(int argc, char *argv[])
 		{
 			// setting mandatory parameters
 			// TODO: upercase
-			auto format        = result["format"].as<std::string>();
-			auto httpPort      = result["httpport"].as<int>();
-			auto maxClients    = result["maxclients"].as<int>();
-			auto slimprotoPort = result["slimprotoport"].as<int>();
+			auto budget         = result["budget"].as<unsigned int>();
+			auto encoderThreads = result["encoderthreads"].as<unsigned int>();
+			auto format         = result["format"].as<std::string>();
+			auto history        = result["history"].as<std::size_t>();
+			auto httpPort       = result["httpport"].as<int>();
+			auto ioThreads      = result["iothreads"].as<unsigned int>();
+			auto maxClients     = result["maxclients"].as<int>();
+			auto packed         = result.count("packed") > 0;
+			auto slimprotoPort  = result["slimprotoport"].as<int>();
 
 			// setting optional parameters
 			auto gain{type_safe::optional<unsigned int>{0}};
@@ -289,16 +320,29 @@ int main(int argc, char *argv[])
 				gain = result["gain"].as<unsigned int>();
 			}
 
+			// history must keep at least one chunk as it is shared by all sessions
+			if (history == 0)
+			{
+				throw cxxopts::OptionException("Invalid history size, it must be greater than 0");
+			}
+
 			// validating parameters and setting format selection
 			std::string    pcm{"PCM"};
 			std::string    flac{"FLAC"};
 			EncoderBuilder encoderBuilder;
+
+			// compression controller is kept here so that its stats can be reported once streaming is stopped
+			std::shared_ptr<flac::CompressionController> controllerPtr;
+
 			encoderBuilder.setHeader(false);
 			if (format == pcm)
 			{
-				encoderBuilder.setBuilder([](unsigned int ch, unsigned int bs, unsigned int bv, unsigned int sr, bool hd, std::string ex, std::string mm, std::function<void(unsigned char*, std::size_t)> ec)
+				encoderBuilder.setBuilder([=](unsigned int ch, unsigned int bs, unsigned int bv, unsigned int sr, bool hd, std::string ex, std::string mm, std::function<void(unsigned char*, std::size_t)> ec)
 				{
-					return std::move(std::unique_ptr<EncoderBase>{new wave::Encoder{ch, bs, bv, sr, hd, ex, mm, ec}});
+					auto encoderPtr{std::make_unique<wave::Encoder>(ch, bs, bv, sr, hd, ex, mm, ec)};
+					encoderPtr->setPacked(packed);
+
+					return std::move(std::unique_ptr<EncoderBase>{std::move(encoderPtr)});
 				});
 				encoderBuilder.setFormat(slim::proto::FormatSelection::PCM);
 				encoderBuilder.setExtention("wav");
@@ -306,9 +350,29 @@ int main(int argc, char *argv[])
 			}
 			else if (format == flac)
 			{
-				encoderBuilder.setBuilder([](unsigned int ch, unsigned int bs, unsigned int bv, unsigned int sr, bool hd, std::string ex, std::string mm, std::function<void(unsigned char*, std::size_t)> ec)
+				if (budget > 100)
+				{
+					throw cxxopts::OptionException("Invalid CPU budget, only values between 0 and 100 are supported");
+				}
+
+				// compression controller outlives encoders as they are created per stream
+				if (budget > 0)
 				{
-					return std::move(std::unique_ptr<EncoderBase>{new flac::Encoder{ch, bs, bv, sr, hd, ex, mm, ec}});
+					controllerPtr = std::make_shared<flac::CompressionController>(0, 8, budget, std::chrono::seconds{5});
+				}
+
+				encoderBuilder.setBuilder([=](unsigned int ch, unsigned int bs, unsigned int bv, unsigned int sr, bool hd, std::string ex, std::string mm, std::function<void(unsigned char*, std::size_t)> ec)
+				{
+					auto encoderPtr{std::make_unique<flac::Encoder>(ch, bs, bv, sr, hd, ex, mm, ec)};
+					encoderPtr->setCompressionController(controllerPtr);
+
+					// one encoding thread is provided by the encoding stage, others are used by libFLAC (one thread means no extra threads)
+					if (encoderThreads > 2)
+					{
+						encoderPtr->setThreads(encoderThreads - 1);
+					}
+
+					return std::move(std::unique_ptr<EncoderBase>{std::move(encoderPtr)});
 				});
 				encoderBuilder.setFormat(slim::proto::FormatSelection::FLAC);
 				encoderBuilder.setExtention("flac");
@@ -321,11 +385,44 @@ int main(int argc, char *argv[])
 
 			// creating 'template' parameters
 			Parameters parameters{"", 3, SND_PCM_FORMAT_S32_LE, 0, 128, 0, 8};
+			parameters.setMemoryMapped(result.count("mmap"));
+			parameters.setMemoryLocked(result.count("lockmemory"));
+			if (result.count("priority"))
+			{
+				auto priority{result["priority"].as<int>()};
+				if (priority < sched_get_priority_min(SCHED_FIFO) || priority > sched_get_priority_max(SCHED_FIFO))
+				{
+					throw cxxopts::OptionException("Invalid real-time priority, only values between 1 and 99 are supported");
+				}
+				parameters.setRealTimePriority(priority);
+			}
+			if (result.count("affinity"))
+			{
+				parameters.setCPUAffinity(result["affinity"].as<std::vector<unsigned int>>());
+			}
 
 			// pre-configuring an encoder builder
 			encoderBuilder.setChannels(parameters.getLogicalChannels());
 			encoderBuilder.setBitsPerSample(parameters.getBitsPerSample());
 			encoderBuilder.setBitsPerValue(parameters.getBitsPerValue());
+			if (packed && encoderBuilder.getFormat() == slim::proto::FormatSelection::PCM && parameters.getBitsPerSample() == 32)
+			{
+				encoderBuilder.setEncodedBitsPerSample(wave::Encoder::getPackedBitsPerSample(parameters.getBitsPerValue()));
+			}
+			else
+			{
+				encoderBuilder.setEncodedBitsPerSample(parameters.getBitsPerSample());
+			}
+
+			// I/O threads must outlive the processor as connections are disposed within the processor
+			std::unique_ptr<IOThreadPool>         ioThreadPoolPtr;
+			type_safe::optional_ref<IOThreadPool> ioThreadPool{type_safe::nullopt};
+			if (ioThreads > 0)
+			{
+				ioThreadPoolPtr = std::make_unique<IOThreadPool>(ioThreads);
+				ioThreadPoolPtr->start();
+				ioThreadPool = type_safe::optional_ref<IOThreadPool>{*ioThreadPoolPtr};
+			}
 
 			// TODO: streamer is not owned by any container in case when PCM is directed to files; consider a better way
 			std::unique_ptr<Streamer<TCPConnection>> streamerPtr;
@@ -340,16 +437,16 @@ int main(int argc, char *argv[])
 				auto multiplexorPtr{std::make_unique<Multiplexor<Source>>(processorProxy, std::move(producers))};
 
 				// creating a streamer object
-				streamerPtr = std::move(std::make_unique<Streamer<TCPConnection>>(processorProxy, httpPort, encoderBuilder, gain));
+				streamerPtr = std::move(std::make_unique<Streamer<TCPConnection>>(processorProxy, httpPort, encoderBuilder, gain, history, encoderThreads > 0));
 
 				// Callbacks objects 'glue' SlimProto Streamer with TCP Command Servers
 				auto commandServerPtr
 				{
-					std::make_unique<TCPServer>(processorProxy, slimprotoPort, maxClients, std::move(createCommandCallbacks(*streamerPtr)))
+					std::make_unique<TCPServer>(processorProxy, slimprotoPort, maxClients, std::move(createCommandCallbacks(*streamerPtr)), ioThreadPool)
 				};
 				auto streamingServerPtr
 				{
-					std::make_unique<TCPServer>(processorProxy, httpPort, maxClients, std::move(createStreamingCallbacks(*streamerPtr)))
+					std::make_unique<TCPServer>(processorProxy, httpPort, maxClients, std::move(createStreamingCallbacks(*streamerPtr)), ioThreadPool)
 				};
 				auto discoveryServerPtr
 				{
@@ -381,6 +478,19 @@ int main(int argc, char *argv[])
 			}};
 			LOG(INFO) << "Streaming format is " << format;
 
+			// locking memory once the main structures are allocated; memory allocated later is locked too
+			if (parameters.isMemoryLocked())
+			{
+				try
+				{
+					slim::util::lockMemory();
+				}
+				catch (const Exception& error)
+				{
+					LOG(WARNING) << LABELS{"slim"} << error;
+				}
+			}
+
 			// start streaming
 			processor.process([](auto& context)
 			{
@@ -429,6 +539,18 @@ int main(int argc, char *argv[])
 					schedulerRunning = context.getResource()->isSchedulerRunning();
 				});
 			}
+
+			// compression stats are reported next to the scheduler stats, which are logged while stopping
+			if (controllerPtr)
+			{
+				auto stats{controllerPtr->getStats()};
+
+				LOG(INFO) << "Compression stats (level=" << stats.level
+					<< ", load=" << stats.load
+					<< "%, streams=" << stats.streams
+					<< ", encoding time=" << stats.encodingTime.count()
+					<< "us, stream duration=" << stats.streamDuration.count() << "us)";
+			}
 			LOG(INFO) << "SlimStreamer was stopped";
 		}
 	}
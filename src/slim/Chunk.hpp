@@ -13,9 +13,10 @@
 #pragma once
 
 #include <cstddef>   // std::size_t
+#include <cstdint>   // std::u..._t types
 
 #include "slim/util/BigInteger.hpp"
-#include "slim/util/buffer/HeapBuffer.hpp"
+#include "slim/util/buffer/BufferArena.hpp"
 #include "slim/util/Timestamp.hpp"
 
 
@@ -23,20 +24,14 @@ namespace slim
 {
 	struct Chunk
 	{
-		using BufferType = util::buffer::HeapBuffer<std::uint8_t>;
-
-		inline void allocateBuffer(std::size_t s)
-		{
-			if (buffer.getSize() != s)
-			{
-				buffer = std::move(BufferType{s});
-			}
-			clear();
-		}
+		// payload memory is borrowed from an arena, which may be shared by several producers
+		using ArenaType  = util::buffer::BufferArena<std::uint8_t>;
+		using BufferType = ArenaType::ArenaBufferType;
 
 		inline void clear()
 		{
 			frames = 0;
+			droppedFrames = 0;
 			capturedFrames = 0;
 		}
 
@@ -46,6 +41,7 @@ namespace slim
 		unsigned int     bytesPerSample{0};
 		BufferType       buffer{0};
 		std::size_t      frames{0};
+		std::size_t      droppedFrames{0};  // frames lost due to a capture overrun right before this chunk
 		util::BigInteger capturedFrames{0};
 		util::Timestamp  timestamp;
 	};
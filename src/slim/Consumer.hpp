@@ -41,10 +41,27 @@ namespace slim
 			}
 
 			virtual bool isRunning() = 0;
+
+			// callback is used to resume producing once a consumer is ready to accept a previously refused chunk
+			inline void setReadyCallback(std::function<void()> c)
+			{
+				readyCallback = std::move(c);
+			}
+
 			virtual void start() = 0;
 			virtual void stop(std::function<void()> callback) = 0;
 
+		protected:
+			inline void notifyReady()
+			{
+				if (readyCallback)
+				{
+					readyCallback();
+				}
+			}
+
 		private:
 			conwrap2::ProcessorProxy<std::unique_ptr<ContainerBase>> processorProxy;
+			std::function<void()>                                    readyCallback;
 	};
 }
@@ -66,6 +66,16 @@ namespace slim
 				return channels.value();
 			}
 
+			// bits per sample of the encoded PCM data, which may differ from the input if samples are packed
+			auto getEncodedBitsPerSample()
+			{
+				if (!encodedBitsPerSample.has_value())
+				{
+					throw Exception("Encoded bits-per-sample parameter was not provided");
+				}
+				return encodedBitsPerSample.value();
+			}
+
 			auto getExtention()
 			{
 				if (!extention.has_value())
@@ -145,6 +155,11 @@ namespace slim
 				encodedCallback = ec;
 			}
 
+			void setEncodedBitsPerSample(unsigned int eb)
+			{
+				encodedBitsPerSample = eb;
+			}
+
 			void setExtention(std::string e)
 			{
 				extention = e;
@@ -176,6 +191,7 @@ namespace slim
 			ts::optional<unsigned int>                                     samplingRate{ts::nullopt};
 			ts::optional<unsigned int>                                     bitsPerSample{ts::nullopt};
 			ts::optional<unsigned int>                                     bitsPerValue{ts::nullopt};
+			ts::optional<unsigned int>                                     encodedBitsPerSample{ts::nullopt};
 			ts::optional<std::string>                                      extention{ts::nullopt};
 			ts::optional<slim::proto::FormatSelection>                     format{ts::nullopt};
 			ts::optional<bool>                                             header{ts::nullopt};
@@ -36,10 +36,14 @@ namespace slim
  			, writerPtr{std::move(w)}
  			, headerRequired{eb.getHeader()}
 			, samplingRate{eb.getSamplingRate()}
+			, bitsPerSample{eb.getEncodedBitsPerSample()}
  			{
 				eb.setEncodedCallback([&](auto* data, auto size)
 				{
-					writerPtr->writeAsync(data, size, [](auto error, auto written)
+					// encoded size may differ from the captured size if samples are packed
+					bytesWritten += size;
+
+					writerPtr->writeAsync(data, size, [](auto error, auto written, auto)
 					{
 						if (error)
 						{
@@ -73,7 +77,6 @@ namespace slim
 				auto size{chunk.frames * chunk.bytesPerSample * chunk.channels};
 
 				encoderPtr->encode(chunk.buffer.getData(), size);
-				bytesWritten += size;
 
 				LOG(DEBUG) << LABELS{"slim"} << "Written " << chunk.frames << " frames";
 
@@ -106,7 +109,6 @@ namespace slim
 			{
 				auto               size{static_cast<std::uint32_t>(s)};
 				const unsigned int channels{encoderPtr->getChannels()};
-				const unsigned int bitsPerSample{encoderPtr->getBitsPerSample()};
 				const unsigned int bytesPerFrame{channels * (bitsPerSample >> 3)};
 				const unsigned int byteRate{samplingRate * bytesPerFrame};
 				const char         chunkID[]     = {0x52, 0x49, 0x46, 0x46};
@@ -136,7 +138,7 @@ namespace slim
 				writerPtr->rewind(0);
 
 				// no need to keep string to be sent as BufferedWriter uses its own buffer for async write
-				writerPtr->writeAsync(ss.str(), [&](auto error, auto written)
+				writerPtr->writeAsync(ss.str(), [&](auto error, auto written, auto)
 				{
 					if (!error)
 					{
@@ -150,6 +152,7 @@ namespace slim
 			std::unique_ptr<EncoderBase>       encoderPtr;
 			bool                               headerRequired;
 			unsigned int                       samplingRate;
+			unsigned int                       bitsPerSample;
 			bool                               running{false};
 			std::size_t                        bytesWritten{0};
 	};
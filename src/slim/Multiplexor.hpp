@@ -12,8 +12,12 @@
 
 #pragma once
 
+#include <algorithm>  // std::find_if, std::max, std::min
 #include <conwrap2/ProcessorProxy.hpp>
 #include <chrono>
+#include <cstddef>    // std::size_t
+#include <iterator>   // std::distance
+#include <limits>
 #include <memory>
 #include <thread>
 #include <type_safe/optional_ref.hpp>
@@ -41,6 +45,31 @@ namespace slim
 			Multiplexor(Multiplexor&& rhs) = delete;              // non-movable
 			Multiplexor& operator=(Multiplexor&& rhs) = delete;   // non-move-assignable
 
+			// the smallest queue is the first one to overflow
+			inline std::size_t getQueueCapacity() const
+			{
+				auto result{std::numeric_limits<std::size_t>::max()};
+
+				for (auto& producerPtr : producers)
+				{
+					result = std::min(result, producerPtr->getQueueCapacity());
+				}
+
+				return producers.size() > 0 ? result : 0;
+			}
+
+			inline std::size_t getQueueDepth() const
+			{
+				auto result{std::size_t{0}};
+
+				for (auto& producerPtr : producers)
+				{
+					result = std::max(result, producerPtr->getQueueDepth());
+				}
+
+				return result;
+			}
+
 			inline bool isRunning()
 			{
 				auto result{false};
@@ -59,6 +88,12 @@ namespace slim
 
 			template<typename ConsumerType>
 			inline ts::optional<std::chrono::milliseconds> produceChunk(const ConsumerType& consumer)
+			{
+				return produceChunks(consumer, 1);
+			}
+
+			template<typename ConsumerType>
+			inline ts::optional<std::chrono::milliseconds> produceChunks(const ConsumerType& consumer, std::size_t maxChunks)
 			{
 				auto result{ts::optional<std::chrono::milliseconds>{ts::nullopt}};
 
@@ -68,31 +103,40 @@ namespace slim
 					switchToNextProducer();
 				}
 
-				ts::with(currentProducer, [&](auto& producer)
+				// probing all producers at most once; returning no value means there is nothing to produce until producers signal
+				for (std::size_t i{0}; i < producers.size() && !result.has_value(); i++)
 				{
-					result = producer.produceChunk(consumer);
-				});
+					auto consuming{false};
 
-				// switching to the next producer if there were no chunks produced
-				if (!result.has_value())
-				{
-					switchToNextProducer();
+					ts::with(currentProducer, [&](auto& producer)
+					{
+						result    = producer.produceChunks(consumer, maxChunks);
+						consuming = producer.isConsuming();
+					});
 
-					// counting 'empty switches' to a different producer to issue pauses once none of the producers produce anything
-					if ((++emptySwitches) >= producers.size())
+					// switching to the next producer if there were no chunks produced, unless current producer is in the middle of a stream
+					if (!result.has_value())
 					{
-						result        = 100;
-						emptySwitches = 0;
+						if (consuming)
+						{
+							break;
+						}
+						switchToNextProducer();
 					}
 				}
-				else
-				{
-					emptySwitches = 0;
-				}
 
 				return result;
 			}
 
+			template<typename CallbackType>
+			inline void setEnqueueCallback(CallbackType callback)
+			{
+				for (auto& producerPtr : producers)
+				{
+					producerPtr->setEnqueueCallback(callback);
+				}
+			}
+
 			inline ts::optional<std::chrono::milliseconds> skipChunk()
 			{
 				auto result{ts::optional<std::chrono::milliseconds>{ts::nullopt}};
@@ -139,7 +183,17 @@ namespace slim
 		protected:
 			inline void switchToNextProducer()
 			{
-				if ((++currentProducerIndex) >= producers.size())
+				// switching straight to a producer with an active stream if there is one; round-robin is used to drain the rest
+				auto found{std::find_if(producers.begin(), producers.end(), [&](auto& producerPtr)
+				{
+					return producerPtr->isStreaming();
+				})};
+
+				if (found != producers.end())
+				{
+					currentProducerIndex = std::distance(producers.begin(), found);
+				}
+				else if ((++currentProducerIndex) >= producers.size())
 				{
 					currentProducerIndex = 0;
 				}
@@ -158,6 +212,5 @@ namespace slim
 			std::vector<std::unique_ptr<ProducerType>> producers;
 			unsigned int                               currentProducerIndex{0};
 			ts::optional_ref<ProducerType>             currentProducer{ts::nullopt};
-			unsigned int                               emptySwitches{0};
 	};
 }
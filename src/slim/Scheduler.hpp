@@ -12,31 +12,62 @@
 
 #pragma once
 
+#include <algorithm>  // std::max, std::min
 #include <conwrap2/ProcessorProxy.hpp>
 #include <conwrap2/Timer.hpp>
 #include <chrono>
+#include <cstddef>    // std::size_t
 #include <functional>
 #include <memory>
 #include <scope_guard.hpp>
+#include <type_safe/optional.hpp>
 #include <type_safe/optional_ref.hpp>
 
 #include "slim/ContainerBase.hpp"
 #include "slim/log/log.hpp"
+#include "slim/util/Duration.hpp"
+#include "slim/util/EventNotifier.hpp"
+#include "slim/util/Timestamp.hpp"
 
 
 namespace slim
 {
 	namespace ts = type_safe;
 
+	struct SchedulerStats
+	{
+		std::size_t    queueDepth{0};       // chunks ready to be processed at the beginning of the last quantum
+		std::size_t    maxQueueDepth{0};
+		std::size_t    quantum{0};          // max amount of chunks allowed for the last quantum
+		std::size_t    processedChunks{0};  // chunks processed within the last quantum
+		std::size_t    totalChunks{0};
+		std::size_t    totalQuanta{0};
+		util::Duration chunkCost{0};        // moving average of processing time per chunk
+		util::Duration dispatchLatency{0};  // moving average of the delay before a scheduled quantum is run, which grows with pending I/O work
+	};
+
 	template <class ProducerType, class ConsumerType>
 	class Scheduler
 	{
 		public:
 			Scheduler(conwrap2::ProcessorProxy<std::unique_ptr<ContainerBase>> pp, std::unique_ptr<ProducerType> pr, std::unique_ptr<ConsumerType> cn)
 			: processorProxy{pp}
+			, notifier{processorProxy.getDispatcher()}
 			, producerPtr{std::move(pr)}
 			, consumerPtr{std::move(cn)}
 			{
+				// producers wake up the scheduler once new data is available instead of being polled
+				producerPtr->setEnqueueCallback([&]
+				{
+					notifier.notify();
+				});
+
+				// consumer that refused a chunk wakes up the scheduler once it is able to accept it
+				consumerPtr->setReadyCallback([&]
+				{
+					notifier.notify();
+				});
+
 				LOG(DEBUG) << LABELS{"slim"} << "Scheduler object was created (id=" << this << ")";
 			}
 
@@ -48,6 +79,7 @@ namespace slim
 				{
 					timer.cancel();
 				});
+				notifier.cancel();
 
 				LOG(DEBUG) << LABELS{"slim"} << "Scheduler object was deleted (id=" << this << ")";
 			}
@@ -57,6 +89,11 @@ namespace slim
 			Scheduler(Scheduler&& rhs) = delete;              // non-movable
 			Scheduler& operator=(Scheduler&& rhs) = delete;   // non-move-assignable
 
+			inline const auto& getStats() const
+			{
+				return stats;
+			}
+
 			inline bool isRunning()
 			{
 				return producerPtr->isRunning() || consumerPtr->isRunning();
@@ -75,6 +112,11 @@ namespace slim
 
 			inline void stop(std::function<void()> callback)
 			{
+				// there will be no more notifications from producers
+				notifier.cancel();
+
+				logStats();
+
 				producerPtr->stop([&, callback = std::move(callback)]
 				{
 					consumerPtr->stop(std::move(callback));
@@ -82,13 +124,57 @@ namespace slim
 			}
 
 		protected:
+			inline std::size_t calculateQuantum(std::size_t queueDepth)
+			{
+				// time budget shrinks as dispatch latency grows, so that pending I/O handlers get their turn sooner
+				auto budget{(quantumBudget.count() * quantumBudget.count()) / (quantumBudget.count() + stats.dispatchLatency.count())};
+
+				// if the queue is about to overflow then catching up takes priority over I/O
+				if (queueDepth * 2 > producerPtr->getQueueCapacity())
+				{
+					budget = quantumBudget.count() * 2;
+				}
+
+				// until processing cost is measured, all ready chunks are processed
+				auto quantum{stats.chunkCost.count() > 0 ? static_cast<std::size_t>(budget / stats.chunkCost.count()) : queueDepth};
+
+				return std::max(std::min(quantum, queueDepth), std::size_t{1});
+			}
+
+			inline void logStats()
+			{
+				statsLoggedAt = util::Timestamp::now();
+
+				LOG(INFO) << LABELS{"slim"} << "Scheduler stats (chunks=" << stats.totalChunks
+					<< ", quanta=" << stats.totalQuanta
+					<< ", queue depth=" << stats.queueDepth
+					<< ", max queue depth=" << stats.maxQueueDepth
+					<< ", quantum budget=" << quantumBudget.count()
+					<< "us, chunk cost=" << stats.chunkCost.count()
+					<< "us, dispatch latency=" << stats.dispatchLatency.count() << "us)";
+			}
+
+			inline static void updateAverage(util::Duration& average, util::Duration sample)
+			{
+				// exponential moving average with 1/8 weight of a new sample
+				average += (sample - average) / 8;
+			}
+
 			void processTask()
 			{
 				auto delayProcessing{std::chrono::milliseconds{0}};
+				auto waitForData{false};
 
 				// TODO: should it be with(taskTime){taskTime.cancel()}?
 				taskTimer.reset();
 
+				// quanta started by a notification are not measured as there is no way to tell when data was enqueued
+				ts::with(scheduledAt, [&](auto& timestamp)
+				{
+					updateAverage(stats.dispatchLatency, std::max(util::Timestamp::now() - timestamp, util::Duration{0}));
+				});
+				scheduledAt.reset();
+
 				try
 				{
 					// this safe guard is meant for capturing consumer's errors
@@ -97,16 +183,51 @@ namespace slim
 						stop([] {});
 					};
 
-					// TODO: calculate total chunks per processing quantum
-					// processing up to max(chunksToProcess) chunks within one event-loop quantum
-					for (int chunksToProcess{5}; chunksToProcess > 0 && !delayProcessing.count(); chunksToProcess--)
+					// quantum is sized based on queue depth, measured processing cost and pending I/O work
+					stats.queueDepth    = producerPtr->getQueueDepth();
+					stats.maxQueueDepth = std::max(stats.maxQueueDepth, stats.queueDepth);
+					stats.quantum       = calculateQuantum(stats.queueDepth);
+
+					// stats are logged periodically and also once the queue gets half full, which is a sign of falling behind
+					auto halfFull{stats.queueDepth * 2 > producerPtr->getQueueCapacity()};
+					if ((halfFull && !queueHalfFull) || util::Timestamp::now() - statsLoggedAt >= statsInterval)
+					{
+						logStats();
+					}
+					queueHalfFull = halfFull;
+
+					// producing / consuming up to quantum chunks within one event-loop quantum
+					auto processedChunks{std::size_t{0}};
+					auto startedAt{util::Timestamp::now()};
+					auto result{producerPtr->produceChunks([&](auto& chunk)
 					{
-						// producing / consuming chunk
-						delayProcessing = producerPtr->produceChunk([&](auto& chunk)
+						// quantum should not take longer than capturing a chunk, otherwise capture queue keeps growing
+						if (chunk.samplingRate && chunk.frames)
 						{
-							return consumerPtr->consumeChunk(chunk);
-						}).value_or(std::chrono::milliseconds{0});
+							quantumBudget = util::Duration{std::chrono::seconds{1}} * chunk.frames / chunk.samplingRate;
+						}
+
+						auto consumed{consumerPtr->consumeChunk(chunk)};
+
+						if (consumed)
+						{
+							processedChunks++;
+						}
+
+						return consumed;
+					}, stats.quantum)};
+
+					if (processedChunks > 0)
+					{
+						updateAverage(stats.chunkCost, (util::Timestamp::now() - startedAt) / processedChunks);
 					}
+					stats.processedChunks  = processedChunks;
+					stats.totalChunks     += processedChunks;
+					stats.totalQuanta++;
+
+					// no value means there is no data available at the moment
+					waitForData     = !result.has_value();
+					delayProcessing = result.value_or(std::chrono::milliseconds{0});
 				}
 				catch (const Exception& error)
 				{
@@ -125,15 +246,25 @@ namespace slim
 				// if there is more PCM data to be processed
 				if (isRunning())
 				{
-					if (delayProcessing.count() > 0)
+					if (waitForData)
+					{
+						// processing will be resumed once a producer signals about a new chunk
+						notifier.wait([&]
+						{
+							processTask();
+						});
+					}
+					else if (delayProcessing.count() > 0)
 					{
-						taskTimer = ts::ref(processorProxy.processWithDelay([&]
+						scheduledAt = util::Timestamp::now() + delayProcessing;
+						taskTimer   = ts::ref(processorProxy.processWithDelay([&]
 						{
 							processTask();
 						}, delayProcessing));
 					}
 					else
 					{
+						scheduledAt = util::Timestamp::now();
 						processorProxy.process([&]
 						{
 							processTask();
@@ -144,8 +275,17 @@ namespace slim
 
 		private:
 			conwrap2::ProcessorProxy<std::unique_ptr<ContainerBase>> processorProxy;
+			// notifier must outlive producers as it is used by their threads
+			util::EventNotifier                                      notifier;
 			std::unique_ptr<ProducerType>                            producerPtr;
 			std::unique_ptr<ConsumerType>                            consumerPtr;
 			ts::optional_ref<conwrap2::Timer>                        taskTimer{ts::nullopt};
+			ts::optional<util::Timestamp>                            scheduledAt{ts::nullopt};
+			// budget is equal to chunk duration; the initial value is used until the first chunk is seen
+			util::Duration                                           quantumBudget{std::chrono::milliseconds{10}};
+			util::Duration                                           statsInterval{std::chrono::minutes{1}};
+			util::Timestamp                                          statsLoggedAt{util::Timestamp::now()};
+			bool                                                     queueHalfFull{false};
+			SchedulerStats                                           stats;
 	};
 }
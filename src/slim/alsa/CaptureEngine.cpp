@@ -0,0 +1,290 @@
+/*
+ * Copyright 2017, Andrej Kislovskij
+ *
+ * This is PUBLIC DOMAIN software so use at your own risk as it comes
+ * with no warranties. This code is yours to share, use and modify without
+ * any restrictions or obligations.
+ *
+ * For more information see conwrap/LICENSE or refer refer to http://unlicense.org
+ *
+ * Author: gimesketvirtadieni at gmail dot com (Andrej Kislovskij)
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>  // std::size_t
+#include <cstdint>  // std::u..._t types
+#include <cstring>  // std::strerror
+#include <poll.h>
+#include <string>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <utility>  // std::move
+
+#include "slim/alsa/CaptureEngine.hpp"
+#include "slim/alsa/Source.hpp"
+#include "slim/util/RealTime.hpp"
+
+
+namespace slim
+{
+	namespace alsa
+	{
+		CaptureEngine::CaptureEngine(int rp, std::vector<unsigned int> ca)
+		: realTimePriority{rp}
+		, cpuAffinity{std::move(ca)}
+		, wakeupDescriptor{::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)}
+		{
+			if (wakeupDescriptor < 0)
+			{
+				throw Exception(std::string{"Could not create eventfd: "} + std::strerror(errno));
+			}
+		}
+
+
+		CaptureEngine::~CaptureEngine()
+		{
+			{
+				std::scoped_lock<std::mutex> lockGuard{lock};
+				stopThread();
+			}
+			::close(wakeupDescriptor);
+		}
+
+
+		void CaptureEngine::add(Source& source)
+		{
+			std::scoped_lock<std::mutex> lockGuard{lock};
+			sources.push_back(&source);
+		}
+
+
+		void CaptureEngine::capture(std::vector<Source*> snapshot)
+		{
+			struct Entry
+			{
+				Source*      sourcePtr;
+				std::size_t  offset;
+				unsigned int count;
+				bool         resuming{false};
+			};
+
+			std::vector<Entry>  entries;
+			std::vector<pollfd> descriptors{pollfd{wakeupDescriptor, POLLIN, 0}};
+
+			// descriptors of a resuming device are masked so that poll does not keep signalling errors while device is not ready
+			auto maskDescriptors{[&](Entry& entry, bool resuming)
+			{
+				if (entry.resuming != resuming)
+				{
+					for (unsigned int i = 0; i < entry.count; i++)
+					{
+						descriptors[entry.offset + i].fd = ~descriptors[entry.offset + i].fd;
+					}
+					entry.resuming = resuming;
+				}
+			}};
+
+			// opening all devices and collecting their poll descriptors; a device that can not be opened is excluded
+			for (auto sourcePtr : snapshot)
+			{
+				std::scoped_lock<std::mutex> lockGuard{sourcePtr->deviceLock};
+				try
+				{
+					sourcePtr->open();
+
+					auto count{snd_pcm_poll_descriptors_count(sourcePtr->handlePtr)};
+					if (count <= 0)
+					{
+						throw Exception(sourcePtr->formatError("Cannot get poll descriptors count", count));
+					}
+
+					auto offset{descriptors.size()};
+					descriptors.resize(offset + count);
+					if (auto result{snd_pcm_poll_descriptors(sourcePtr->handlePtr, &descriptors[offset], count)}; result < 0)
+					{
+						descriptors.resize(offset);
+						throw Exception(sourcePtr->formatError("Cannot get poll descriptors", result));
+					}
+
+					entries.push_back(Entry{sourcePtr, offset, static_cast<unsigned int>(count), false});
+				}
+				catch (const Exception& error)
+				{
+					LOG(ERROR) << LABELS{"alsa"} << "Device was excluded from capturing: " << error;
+					sourcePtr->close();
+				}
+			}
+
+			// everything inside this loop (except error handling) must be real-time safe: no memory allocation, no logging, etc.
+			while (running)
+			{
+				// resuming devices are retried on a timeout instead of blocking this thread which is shared by all devices
+				auto resuming{std::any_of(entries.begin(), entries.end(), [](auto& entry) {return entry.resuming;})};
+
+				if (::poll(descriptors.data(), descriptors.size(), resuming ? Source::resumeRetryTimeout : -1) < 0)
+				{
+					if (errno == EINTR)
+					{
+						continue;
+					}
+
+					LOG(ERROR) << LABELS{"alsa"} << "Error while polling audio devices: " << std::strerror(errno);
+					break;
+				}
+
+				// wakeup descriptor is used only to interrupt polling when the engine is stopped
+				if (descriptors[0].revents)
+				{
+					std::uint64_t value;
+					[[maybe_unused]] auto result{::read(wakeupDescriptor, &value, sizeof(value))};
+					continue;
+				}
+
+				for (auto& entry : entries)
+				{
+					auto result{snd_pcm_sframes_t{0}};
+
+					if (entry.resuming)
+					{
+						// resume is attempted again on every wakeup until device is ready
+						result = -ESTRPIPE;
+					}
+					else if (descriptors[entry.offset].fd < 0)
+					{
+						// descriptors of a failed device are disabled
+						continue;
+					}
+					else
+					{
+						unsigned short revents{0};
+						snd_pcm_poll_descriptors_revents(entry.sourcePtr->handlePtr, &descriptors[entry.offset], entry.count, &revents);
+
+						// reading one chunk per event; if there is more data then poll will signal straight away
+						if (revents & (POLLIN | POLLERR))
+						{
+							result = entry.sourcePtr->read();
+						}
+					}
+
+					if (result < 0 && result != -EAGAIN)
+					{
+						if (entry.sourcePtr->restore(result))
+						{
+							maskDescriptors(entry, entry.sourcePtr->resuming);
+						}
+						else
+						{
+							LOG(ERROR) << LABELS{"alsa"} << entry.sourcePtr->formatError("Unexpected error while reading PCM data", result);
+
+							// negative descriptors are ignored by poll
+							maskDescriptors(entry, false);
+							for (unsigned int i = 0; i < entry.count; i++)
+							{
+								descriptors[entry.offset + i].fd = -1;
+							}
+						}
+					}
+				}
+			}
+
+			// closing all devices
+			for (auto& entry : entries)
+			{
+				std::scoped_lock<std::mutex> lockGuard{entry.sourcePtr->deviceLock};
+				entry.sourcePtr->close();
+			}
+		}
+
+
+		void CaptureEngine::remove(Source& source)
+		{
+			std::scoped_lock<std::mutex> lockGuard{lock};
+			sources.erase(std::remove(sources.begin(), sources.end(), &source), sources.end());
+
+			// capture thread must not refer to a removed source, so it is restarted without it
+			if (std::find(capturedSources.begin(), capturedSources.end(), &source) != capturedSources.end())
+			{
+				stopThread();
+				if (startedSources > 0)
+				{
+					startThread();
+				}
+			}
+		}
+
+
+		void CaptureEngine::start()
+		{
+			std::scoped_lock<std::mutex> lockGuard{lock};
+			if (startedSources++ == 0)
+			{
+				startThread();
+			}
+		}
+
+
+		void CaptureEngine::startThread()
+		{
+			running = true;
+
+			// capture thread works with its own copy, so sources may be added or removed concurrently
+			capturedSources = sources;
+
+			// starting one capture thread for all devices
+			captureThread = std::thread{[&, snapshot = capturedSources]() mutable
+			{
+				LOG(DEBUG) << LABELS{"slim"} << "PCM data capture thread was started (id=" << std::this_thread::get_id() << ", devices=" << snapshot.size() << ")";
+
+				try
+				{
+					util::applyThreadSettings(realTimePriority, cpuAffinity);
+					capture(std::move(snapshot));
+				}
+				catch (const Exception& error)
+				{
+					LOG(ERROR) << LABELS{"slim"} << "Error in capture thread: " << error;
+				}
+				catch (const std::exception& error)
+				{
+					LOG(ERROR) << LABELS{"slim"} << "Error in capture thread: " << error.what();
+				}
+				catch (...)
+				{
+					LOG(ERROR) << LABELS{"slim"} << "Unexpected exception";
+				}
+
+				LOG(DEBUG) << LABELS{"slim"} << "PCM data capture thread was stopped (id=" << std::this_thread::get_id() << ")";
+			}};
+		}
+
+
+		void CaptureEngine::stop()
+		{
+			std::scoped_lock<std::mutex> lockGuard{lock};
+			if (startedSources > 0 && --startedSources == 0)
+			{
+				stopThread();
+			}
+		}
+
+
+		void CaptureEngine::stopThread()
+		{
+			if (running)
+			{
+				running = false;
+
+				// interrupting poll so the capture thread can terminate
+				std::uint64_t value{1};
+				[[maybe_unused]] auto result{::write(wakeupDescriptor, &value, sizeof(value))};
+			}
+
+			if (captureThread.joinable())
+			{
+				captureThread.join();
+			}
+			capturedSources.clear();
+		}
+	}
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright 2017, Andrej Kislovskij
+ *
+ * This is PUBLIC DOMAIN software so use at your own risk as it comes
+ * with no warranties. This code is yours to share, use and modify without
+ * any restrictions or obligations.
+ *
+ * For more information see conwrap/LICENSE or refer refer to http://unlicense.org
+ *
+ * Author: gimesketvirtadieni at gmail dot com (Andrej Kislovskij)
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>  // std::size_t
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace slim
+{
+	namespace alsa
+	{
+		class Source;
+
+		// captures all registered sources within one thread by multiplexing their devices with poll()
+		class CaptureEngine
+		{
+			public:
+				CaptureEngine(int rp = 0, std::vector<unsigned int> ca = {});
+				~CaptureEngine();
+				CaptureEngine(const CaptureEngine&) = delete;             // non-copyable
+				CaptureEngine& operator=(const CaptureEngine&) = delete;  // non-assignable
+				CaptureEngine(CaptureEngine&& rhs) = delete;              // non-movable
+				CaptureEngine& operator=(CaptureEngine&& rhs) = delete;   // non-move-assignable
+
+				void add(Source& source);
+
+				inline bool isRunning()
+				{
+					return running;
+				}
+
+				void remove(Source& source);
+
+				// capture thread keeps running while at least one source is started
+				void start();
+				void stop();
+
+			protected:
+				void capture(std::vector<Source*> snapshot);
+				void startThread();
+				void stopThread();
+
+			private:
+				int                       realTimePriority;
+				std::vector<unsigned int> cpuAffinity;
+				std::vector<Source*>      sources;
+				std::vector<Source*>      capturedSources;  // sources used by the capture thread; it is only changed when the thread is not running
+				std::size_t               startedSources{0};
+				std::thread               captureThread;
+				std::atomic<bool>         running{false};
+				std::mutex                lock;
+				int                       wakeupDescriptor{-1};
+		};
+	}
+}
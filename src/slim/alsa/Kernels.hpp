@@ -0,0 +1,230 @@
+/*
+ * Copyright 2017, Andrej Kislovskij
+ *
+ * This is PUBLIC DOMAIN software so use at your own risk as it comes
+ * with no warranties. This code is yours to share, use and modify without
+ * any restrictions or obligations.
+ *
+ * For more information see conwrap/LICENSE or refer refer to http://unlicense.org
+ *
+ * Author: gimesketvirtadieni at gmail dot com (Andrej Kislovskij)
+ */
+
+#pragma once
+
+#include <cstddef>  // std::size_t, std::ptrdiff_t
+#include <cstring>  // std::memcpy
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "slim/alsa/StreamMarker.hpp"
+
+
+namespace slim
+{
+	namespace alsa
+	{
+		namespace kernels
+		{
+			// scalar implementations support any frame layout; they are also used as a reference by vectorized kernels
+			inline std::ptrdiff_t findDataScalar(const unsigned char* buffer, std::size_t frames, std::size_t bytesPerFrame, bool& producing)
+			{
+				for (std::size_t i = 0; i < frames; i++)
+				{
+					// processing PCM data marker
+					StreamMarker value{buffer[(i + 1) * bytesPerFrame - 1]};  // last byte of the current frame
+					if (value == StreamMarker::beginningOfStream)
+					{
+						producing = true;
+					}
+					else if (value == StreamMarker::endOfStream)
+					{
+						producing = false;
+					}
+					else if (value == StreamMarker::data && producing)
+					{
+						return static_cast<std::ptrdiff_t>(i);
+					}
+				}
+
+				return -1;
+			}
+
+			inline std::size_t stripMarkerScalar(const unsigned char* srcBuffer, unsigned char* dstBuffer, std::size_t frames, std::size_t bytesPerFrame, std::size_t bytesPerSample, bool& producing)
+			{
+				auto bytesToCopy{bytesPerFrame - bytesPerSample};
+				auto framesCopied{std::size_t{0}};
+
+				for (std::size_t i = 0; i < frames; i++)
+				{
+					StreamMarker value{srcBuffer[(i + 1) * bytesPerFrame - 1]};  // last byte of the current frame
+					if (value == StreamMarker::beginningOfStream)
+					{
+						producing = true;
+					}
+					else if (value == StreamMarker::endOfStream)
+					{
+						producing = false;
+					}
+					else if (value == StreamMarker::data && producing)
+					{
+						// copying all channels except the last one
+						std::memcpy(dstBuffer, srcBuffer + i * bytesPerFrame, bytesToCopy);
+						dstBuffer += bytesToCopy;
+						framesCopied++;
+					}
+				}
+
+				return framesCopied;
+			}
+
+#if defined(__AVX2__) || defined(__SSE2__)
+			// vectorized kernels are specialized for S32_LE samples with two logical channels and a marker channel
+			constexpr std::size_t vectorBytesPerFrame{12};
+			constexpr std::size_t vectorBytesPerSample{4};
+
+#if defined(__AVX2__)
+			constexpr std::size_t framesPerGroup{8};
+
+			// returns a mask with one bit per frame of a group which marker is equal to the provided value
+			inline unsigned int matchMarkers(const unsigned char* group, StreamMarker value)
+			{
+				auto pattern{_mm256_set1_epi8(static_cast<char>(value))};
+				auto m0{static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(group)), pattern)))};
+				auto m1{static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(group + 32)), pattern)))};
+				auto m2{static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(group + 64)), pattern)))};
+
+				// marker bytes are located at offsets 11, 23, 35, 47, 59, 71, 83 and 95 within a group
+				return ((m0 >> 11) & 0x01) | ((m0 >> 22) & 0x02) |
+				       ((m1 >> 1)  & 0x04) | ((m1 >> 12) & 0x08) | ((m1 >> 23) & 0x10) |
+				       ((m2 >> 2)  & 0x20) | ((m2 >> 13) & 0x40) | ((m2 >> 24) & 0x80);
+			}
+
+			inline void copyGroup(const unsigned char* srcBuffer, unsigned char* dstBuffer)
+			{
+				auto y0{_mm256_loadu_si256(reinterpret_cast<const __m256i*>(srcBuffer))};
+				auto y1{_mm256_loadu_si256(reinterpret_cast<const __m256i*>(srcBuffer + 32))};
+				auto y2{_mm256_loadu_si256(reinterpret_cast<const __m256i*>(srcBuffer + 64))};
+
+				// gathering two logical channels out of every three 32-bit samples
+				auto out0{_mm256_blend_epi32(
+					_mm256_permutevar8x32_epi32(y0, _mm256_setr_epi32(0, 1, 3, 4, 6, 7, 0, 0)),
+					_mm256_permutevar8x32_epi32(y1, _mm256_setr_epi32(0, 0, 0, 0, 0, 0, 1, 2)), 0xC0)};
+				auto out1{_mm256_blend_epi32(
+					_mm256_permutevar8x32_epi32(y1, _mm256_setr_epi32(4, 5, 7, 0, 0, 0, 0, 0)),
+					_mm256_permutevar8x32_epi32(y2, _mm256_setr_epi32(0, 0, 0, 0, 2, 3, 5, 6)), 0xF8)};
+
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(dstBuffer), out0);
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(dstBuffer + 32), out1);
+			}
+#else
+			constexpr std::size_t framesPerGroup{4};
+
+			// returns a mask with one bit per frame of a group which marker is equal to the provided value
+			inline unsigned int matchMarkers(const unsigned char* group, StreamMarker value)
+			{
+				auto pattern{_mm_set1_epi8(static_cast<char>(value))};
+				auto m0{static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(group)), pattern)))};
+				auto m1{static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(group + 16)), pattern)))};
+				auto m2{static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(group + 32)), pattern)))};
+
+				// marker bytes are located at offsets 11, 23, 35 and 47 within a group
+				return ((m0 >> 11) & 0x01) | ((m1 >> 6) & 0x02) | ((m2 >> 1) & 0x04) | ((m2 >> 12) & 0x08);
+			}
+
+			inline void copyGroup(const unsigned char* srcBuffer, unsigned char* dstBuffer)
+			{
+				auto x0{_mm_loadu_ps(reinterpret_cast<const float*>(srcBuffer))};
+				auto x1{_mm_loadu_ps(reinterpret_cast<const float*>(srcBuffer + 16))};
+				auto x2{_mm_loadu_ps(reinterpret_cast<const float*>(srcBuffer + 32))};
+
+				// gathering two logical channels out of every three 32-bit samples; float shuffles do not alter bit patterns
+				auto t{_mm_shuffle_ps(x0, x1, _MM_SHUFFLE(0, 0, 3, 3))};
+				auto out0{_mm_shuffle_ps(x0, t, _MM_SHUFFLE(2, 0, 1, 0))};
+				auto out1{_mm_shuffle_ps(x1, x2, _MM_SHUFFLE(2, 1, 3, 2))};
+
+				_mm_storeu_ps(reinterpret_cast<float*>(dstBuffer), out0);
+				_mm_storeu_ps(reinterpret_cast<float*>(dstBuffer + 16), out1);
+			}
+#endif
+
+			constexpr unsigned int fullGroupMask{(1u << framesPerGroup) - 1};
+#endif
+
+			// returns an offset of the first frame containing data within an active stream or -1 if there is no such frame
+			inline std::ptrdiff_t findData(const unsigned char* buffer, std::size_t frames, std::size_t bytesPerFrame, std::size_t bytesPerSample, bool& producing)
+			{
+				auto i{std::size_t{0}};
+
+#if defined(__AVX2__) || defined(__SSE2__)
+				if (bytesPerFrame == vectorBytesPerFrame && bytesPerSample == vectorBytesPerSample)
+				{
+					for (; i + framesPerGroup <= frames; i += framesPerGroup)
+					{
+						auto group{buffer + i * bytesPerFrame};
+
+						// a group is skipped if none of its markers may change the state or contain data within an active stream
+						auto matched{producing ?
+							matchMarkers(group, StreamMarker::endOfStream) | matchMarkers(group, StreamMarker::data) :
+							matchMarkers(group, StreamMarker::beginningOfStream)};
+
+						if (matched)
+						{
+							if (auto offset{findDataScalar(group, framesPerGroup, bytesPerFrame, producing)}; offset >= 0)
+							{
+								return static_cast<std::ptrdiff_t>(i) + offset;
+							}
+						}
+					}
+				}
+#endif
+
+				// processing frames which do not fit into a group
+				if (auto offset{findDataScalar(buffer + i * bytesPerFrame, frames - i, bytesPerFrame, producing)}; offset >= 0)
+				{
+					return static_cast<std::ptrdiff_t>(i) + offset;
+				}
+
+				return -1;
+			}
+
+			// copies frames containing data within an active stream without the last (marker) channel; returns amount of copied frames
+			inline std::size_t stripMarker(const unsigned char* srcBuffer, unsigned char* dstBuffer, std::size_t frames, std::size_t bytesPerFrame, std::size_t bytesPerSample, bool& producing)
+			{
+				auto i{std::size_t{0}};
+				auto framesCopied{std::size_t{0}};
+				auto bytesToCopy{bytesPerFrame - bytesPerSample};
+
+#if defined(__AVX2__) || defined(__SSE2__)
+				if (bytesPerFrame == vectorBytesPerFrame && bytesPerSample == vectorBytesPerSample)
+				{
+					for (; i + framesPerGroup <= frames; i += framesPerGroup)
+					{
+						auto group{srcBuffer + i * bytesPerFrame};
+
+						// a group consisting of data frames only does not change the state so it is copied in one go
+						if (producing && matchMarkers(group, StreamMarker::data) == fullGroupMask)
+						{
+							copyGroup(group, dstBuffer + framesCopied * bytesToCopy);
+							framesCopied += framesPerGroup;
+						}
+						else
+						{
+							framesCopied += stripMarkerScalar(group, dstBuffer + framesCopied * bytesToCopy, framesPerGroup, bytesPerFrame, bytesPerSample, producing);
+						}
+					}
+				}
+#endif
+
+				// processing frames which do not fit into a group
+				framesCopied += stripMarkerScalar(srcBuffer + i * bytesPerFrame, dstBuffer + framesCopied * bytesToCopy, frames - i, bytesPerFrame, bytesPerSample, producing);
+
+				return framesCopied;
+			}
+		}
+	}
+}
@@ -16,6 +16,8 @@
 #include <cstddef>  // std::size_t
 #include <memory>
 #include <string>
+#include <utility>  // std::move
+#include <vector>
 
 
 namespace slim
@@ -32,7 +34,8 @@ namespace slim
 				, samplingRate{r}
 				, queueSize{qs}
 				, framesPerChunk{fc}
-				, periods{p} {}
+				, periods{p}
+				, reservedChunks{qs} {}
 
 				// using Rule Of Zero
 			   ~Parameters() = default;
@@ -51,6 +54,11 @@ namespace slim
 					return static_cast<unsigned int>(snd_pcm_format_width(format));
 				}
 
+				inline const std::vector<unsigned int>& getCPUAffinity() const
+				{
+					return cpuAffinity;
+				}
+
 				inline const std::string getDeviceName() const
 				{
 					return deviceName;
@@ -82,6 +90,16 @@ namespace slim
 					return periods;
 				}
 
+				inline const int getRealTimePriority() const
+				{
+					return realTimePriority;
+				}
+
+				inline const std::size_t getReservedChunks() const
+				{
+					return reservedChunks;
+				}
+
 				inline const unsigned int getSamplingRate() const
 				{
 					return samplingRate;
@@ -98,6 +116,22 @@ namespace slim
 					return channels;
 				}
 
+				inline const bool isMemoryLocked() const
+				{
+					return memoryLocked;
+				}
+
+				inline const bool isMemoryMapped() const
+				{
+					return memoryMapped;
+				}
+
+				// empty list means capture thread is not pinned to any CPU
+				inline void setCPUAffinity(std::vector<unsigned int> c)
+				{
+					cpuAffinity = std::move(c);
+				}
+
 				inline void setDeviceName(std::string d)
 				{
 					deviceName = d;
@@ -108,19 +142,45 @@ namespace slim
 					framesPerChunk = f;
 				}
 
+				inline void setMemoryLocked(bool m)
+				{
+					memoryLocked = m;
+				}
+
+				inline void setMemoryMapped(bool m)
+				{
+					memoryMapped = m;
+				}
+
+				// zero means capture thread uses default scheduling policy
+				inline void setRealTimePriority(int p)
+				{
+					realTimePriority = p;
+				}
+
+				inline void setReservedChunks(std::size_t r)
+				{
+					reservedChunks = r;
+				}
+
 				inline void setSamplingRate(unsigned int r)
 				{
 					samplingRate = r;
 				}
 
 			private:
-				std::string       deviceName;
-				unsigned int      channels;
-				snd_pcm_format_t  format;
-				unsigned int      samplingRate;
-				std::size_t       queueSize;
-				snd_pcm_uframes_t framesPerChunk;
-				unsigned int      periods;
+				std::string               deviceName;
+				unsigned int              channels;
+				snd_pcm_format_t          format;
+				unsigned int              samplingRate;
+				std::size_t               queueSize;
+				snd_pcm_uframes_t         framesPerChunk;
+				unsigned int              periods;
+				std::size_t               reservedChunks;
+				bool                      memoryMapped{false};
+				bool                      memoryLocked{false};
+				int                       realTimePriority{0};
+				std::vector<unsigned int> cpuAffinity;
 		};
 	}
 }
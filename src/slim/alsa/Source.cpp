@@ -11,86 +11,222 @@
  */
 
 #include <algorithm>
+#include <cstring>  // std::memset
+#include <poll.h>
 #include <scope_guard.hpp>
 #include <string>
 
+#include "slim/alsa/CaptureEngine.hpp"
+#include "slim/alsa/Kernels.hpp"
 #include "slim/alsa/Source.hpp"
+#include "slim/util/RealTime.hpp"
 
 
 namespace slim
 {
 	namespace alsa
 	{
-		void Source::close() noexcept
+		Source::Source(conwrap2::ProcessorProxy<std::unique_ptr<ContainerBase>> pp, Parameters pa, std::shared_ptr<CaptureEngine> ce, std::shared_ptr<Chunk::ArenaType> ca, std::function<void()> oc)
+		: parameters{pa}
+		, captureEnginePtr{std::move(ce)}
+		, chunkArenaPtr{std::move(ca)}
+		, overflowCallback{std::move(oc)}
+		, queue{parameters.getQueueSize(), std::move([&](Chunk& chunk)
 		{
-			if (int result{snd_pcm_close(handlePtr)}; result < 0)
+			if (heldChunks < parameters.getReservedChunks() && chunkArenaPtr->getBufferSize() >= getChunkSize(parameters))
+			{
+				if ((chunk.buffer = chunkArenaPtr->allocate()).getData())
+				{
+					// reserved memory is pre-faulted so that the capture thread does not hit page faults
+					std::memset(chunk.buffer.getData(), 0, chunk.buffer.getSize());
+					heldChunks++;
+				}
+			}
+		})}
+		{
+			if (chunkArenaPtr->getBufferSize() < getChunkSize(parameters))
+			{
+				throw Exception(formatError("Chunk arena buffer size is too small"));
+			}
+
+			if (captureEnginePtr)
 			{
-				LOG(WARNING) << LABELS{"slim"} << formatError("Error while closing audio device", result);
+				captureEnginePtr->add(*this);
 			}
 		}
 
 
-		snd_pcm_sframes_t Source::containsData(unsigned char* buffer, snd_pcm_uframes_t frames)
+		Source::~Source()
 		{
-			auto offset{-1};
-			auto bytesPerFrame{parameters.getTotalChannels() * (parameters.getBitsPerSample() >> 3)};
+			// it is safe to call stop method multiple times
+			stop([] {});
 
-			for (snd_pcm_uframes_t i = 0; i < frames && offset < 0; i++)
+			if (captureEnginePtr)
 			{
-				// processing PCM data marker
-				StreamMarker value{buffer[(i + 1) * bytesPerFrame - 1]};  // last byte of the current frame
-				if (value == StreamMarker::beginningOfStream)
-				{
-					producing = true;
-				}
-				else if (value == StreamMarker::endOfStream)
-				{
-					producing = false;
-				}
-				else if (value == StreamMarker::data && producing)
+				captureEnginePtr->remove(*this);
+			}
+		}
+
+
+		void Source::close() noexcept
+		{
+			if (handlePtr)
+			{
+				if (int result{snd_pcm_close(handlePtr)}; result < 0)
 				{
-					offset = i;
+					LOG(WARNING) << LABELS{"slim"} << formatError("Error while closing audio device", result);
 				}
+				handlePtr = nullptr;
 			}
+		}
+
+
+		snd_pcm_sframes_t Source::containsData(unsigned char* buffer, snd_pcm_uframes_t frames)
+		{
+			auto bytesPerSample{parameters.getBitsPerSample() >> 3};
+			auto bytesPerFrame{parameters.getTotalChannels() * bytesPerSample};
 
-			return offset;
+			// after a gap stream is continued only if the first received frame carries data; otherwise markers are processed as usual
+			if (resynchronizing && frames > 0)
+			{
+				producing       = (static_cast<StreamMarker>(buffer[bytesPerFrame - 1]) == StreamMarker::data);
+				resynchronizing = false;
+			}
+
+			return kernels::findData(buffer, frames, bytesPerFrame, bytesPerSample, producing);
 		}
 
 
 		snd_pcm_uframes_t Source::copyData(unsigned char* srcBuffer, unsigned char* dstBuffer, snd_pcm_uframes_t frames)
+		{
+			auto bytesPerSample{parameters.getBitsPerSample() >> 3};
+			auto bytesPerFrame{parameters.getTotalChannels() * bytesPerSample};
+
+			// returning copied size in frames
+			return kernels::stripMarker(srcBuffer, dstBuffer, frames, bytesPerFrame, bytesPerSample, producing);
+		}
+
+
+		snd_pcm_uframes_t Source::countLostFrames()
+		{
+			snd_pcm_status_t* statusPtr;
+			snd_pcm_status_alloca(&statusPtr);
+
+			if (snd_pcm_status(handlePtr, statusPtr) < 0)
+			{
+				return 0;
+			}
+
+			// frames which were captured but not read yet are discarded by prepare
+			auto lost{static_cast<std::uint64_t>(snd_pcm_status_get_avail(statusPtr))};
+
+			// device stops capturing when an overrun happens (trigger timestamp) so everything since then is lost as well
+			snd_htimestamp_t now;
+			snd_htimestamp_t trigger;
+			snd_pcm_status_get_htstamp(statusPtr, &now);
+			snd_pcm_status_get_trigger_htstamp(statusPtr, &trigger);
+
+			auto elapsed{(static_cast<std::int64_t>(now.tv_sec) - trigger.tv_sec) * 1000000000 + (now.tv_nsec - trigger.tv_nsec)};
+			if (elapsed > 0 && trigger.tv_sec > 0)
+			{
+				lost += static_cast<std::uint64_t>(elapsed) * parameters.getSamplingRate() / 1000000000;
+			}
+
+			return static_cast<snd_pcm_uframes_t>(lost);
+		}
+
+
+		void Source::enqueueData(unsigned char* buffer, snd_pcm_uframes_t frames)
 		{
 			auto bytesPerFrame{parameters.getTotalChannels() * (parameters.getBitsPerSample() >> 3)};
-			auto framesCopied{snd_pcm_sframes_t{0}};
+			auto timestamp{util::Timestamp::now()};
+			auto offset{containsData(buffer, frames)};
 
-			for (snd_pcm_uframes_t i = 0; i < frames; i++)
+			// if PCM data contains active stream
+			if (offset >= 0)
 			{
-				StreamMarker value{srcBuffer[(i + 1) * bytesPerFrame - 1]};  // last byte of the current frame
-				if (value == StreamMarker::beginningOfStream)
-				{
-					producing = true;
-				}
-				else if (value == StreamMarker::endOfStream)
-				{
-					producing = false;
-				}
-				else if (value == StreamMarker::data && producing)
+				// enqueue received PCM data so that none-Real-Time safe code can process it
+				queue.enqueue([&](Chunk& chunk)
 				{
-					// copying byte-by-byte and skipping the last channel
-					for (unsigned int j = 0; j < (bytesPerFrame - (parameters.getBitsPerSample() >> 3)); j++)
+					// borrowing memory from the arena only when a chunk is about to be filled
+					if (!chunk.buffer.getData())
 					{
-						dstBuffer[j] = srcBuffer[i * bytesPerFrame + j];
+						if (!(chunk.buffer = chunkArenaPtr->allocate()).getData())
+						{
+							// arena is exhausted so this chunk is skipped the same way as if the queue was full
+							overflowCallback();
+							return false;
+						}
+						heldChunks.fetch_add(1, std::memory_order_relaxed);
 					}
 
-					// adjusting destination buffer pointer
-					dstBuffer += parameters.getLogicalChannels() * (parameters.getBitsPerSample() >> 3);
+					// setting chunk 'meta' data
+					chunk.timestamp = timestamp;
+					chunk.samplingRate = parameters.getSamplingRate();
+					chunk.channels = parameters.getLogicalChannels();
+					chunk.bytesPerSample = parameters.getBitsPerSample() >> 3;
+					chunk.endOfStream = false;
+
+					// copying PCM data and setting chunk's payload size in frames
+					auto copiedFrames = copyData(
+						buffer + offset * bytesPerFrame,
+						chunk.buffer.getData(),
+						frames - std::min(static_cast<snd_pcm_uframes_t>(offset), frames));
+
+					// captured frames count only frames delivered downstream, so it stays consistent with what clients receive
+					capturedFrames += copiedFrames;
+					chunk.frames = copiedFrames;
+					chunk.capturedFrames = capturedFrames;
+
+					// notifying consumer about a gap in the stream
+					chunk.droppedFrames = pendingDroppedFrames;
+					pendingDroppedFrames = 0;
+
+					// only the first chunk in stream is marked as Beginning-Of-Stream
+					beginningOfStream = false;
+					streaming.store(true, std::memory_order_relaxed);
+
+					// always true as source buffer contains data
+					return true;
+				}, [&]
+				{
+					// calling overflow callback in case it was not possible to enqueue a chunk
+					overflowCallback();
+				});
 
-					// increasing destination frames counter
-					framesCopied++;
-				}
+				// waking up consumer thread
+				enqueueCallback();
 			}
+			else if (!beginningOfStream)
+			{
+				// submitting an end-of-stream chunk to notify consumer thread about End-Of-Stream
+				queue.enqueue([&](Chunk& chunk)
+				{
+					// setting chunk 'meta' data
+					chunk.timestamp = timestamp;
+					chunk.samplingRate = parameters.getSamplingRate();
+					chunk.channels = parameters.getLogicalChannels();
+					chunk.bytesPerSample = parameters.getBitsPerSample() >> 3;
+					chunk.endOfStream = true;
+					chunk.clear();
+
+					chunk.capturedFrames = capturedFrames;
+
+					// resetting state as the next chunk will initiate a new streaming session
+					beginningOfStream = true;
+					streaming.store(false, std::memory_order_relaxed);
+
+					// always true as source buffer contains data
+					return true;
+				}, [&]
+				{
+					// calling overflow callback in case it was not possible to enqueue a chunk
+					overflowCallback();
+				});
 
-			// returning copied size in frames
-			return framesCopied;
+				// waking up consumer thread
+				enqueueCallback();
+			}
 		}
 
 
@@ -114,7 +250,8 @@ namespace slim
 				}
 			};
 
-			if ((result = snd_pcm_open(&handlePtr, deviceName.c_str(), SND_PCM_STREAM_CAPTURE, 0)) < 0)
+			// capture engine multiplexes all devices within one thread so it requires non-blocking mode
+			if ((result = snd_pcm_open(&handlePtr, deviceName.c_str(), SND_PCM_STREAM_CAPTURE, captureEnginePtr ? SND_PCM_NONBLOCK : 0)) < 0)
 			{
 				throw Exception(formatError("Cannot open audio device", result));
 			}
@@ -126,7 +263,7 @@ namespace slim
 			{
 				throw Exception(formatError("Cannot initialize hardware parameter structure", result));
 			}
-			else if ((result = snd_pcm_hw_params_set_access(handlePtr, hardwarePtr, SND_PCM_ACCESS_RW_INTERLEAVED)) < 0)
+			else if ((result = snd_pcm_hw_params_set_access(handlePtr, hardwarePtr, parameters.isMemoryMapped() ? SND_PCM_ACCESS_MMAP_INTERLEAVED : SND_PCM_ACCESS_RW_INTERLEAVED)) < 0)
 			{
 				throw Exception(formatError("Cannot set access type", result));
 			}
@@ -172,6 +309,12 @@ namespace slim
 			{
 				throw Exception(formatError("Cannot set start threshold", result));
 			}
+
+			// timestamps are used to count frames lost in case of an overrun
+			else if ((result = snd_pcm_sw_params_set_tstamp_mode(handlePtr, softwarePtr, SND_PCM_TSTAMP_ENABLE)) < 0)
+			{
+				throw Exception(formatError("Cannot set timestamp mode", result));
+			}
 			else if ((result = snd_pcm_sw_params(handlePtr, softwarePtr)) < 0)
 			{
 				throw Exception(formatError("Cannot set software parameters", result));
@@ -182,95 +325,103 @@ namespace slim
 			{
 				throw Exception(formatError("Cannot start using audio device", result));
 			}
+
+			// capture engine can not use a stack buffer as it serves many devices
+			if (captureEnginePtr && !parameters.isMemoryMapped())
+			{
+				auto size{parameters.getFramesPerChunk() * parameters.getTotalChannels() * (parameters.getBitsPerSample() >> 3)};
+				if (captureBuffer.getSize() != size)
+				{
+					captureBuffer = std::move(util::buffer::HeapBuffer<std::uint8_t>{size});
+					std::memset(captureBuffer.getData(), 0, size);
+				}
+			}
+
+			beginningOfStream = true;
+			producing         = false;
+			resynchronizing   = false;
+			resuming          = false;
 		}
 
 
 		void Source::produce()
+		{
+			// memory-mapped mode saves one copy per period as PCM data is processed directly in the DMA area
+			if (parameters.isMemoryMapped())
+			{
+				produceMemoryMapped();
+			}
+			else
+			{
+				produceInterleaved();
+			}
+		}
+
+
+		void Source::produceInterleaved()
 		{
 			auto          maxFrames     = parameters.getFramesPerChunk();
 			unsigned int  bytesPerFrame = parameters.getTotalChannels() * (parameters.getBitsPerSample() >> 3);
 			unsigned char srcBuffer[maxFrames * bytesPerFrame];
 
 			auto result{snd_pcm_sframes_t{0}};
-			auto isBeginningOfStream{true};
 
 			// everything inside this loop (except overflowCallback) must be real-time safe: no memory allocation, no logging, etc.
 			while (result >= 0)
 			{
 				// this call will block until buffer is filled or PCM stream state is changed
-				result = snd_pcm_readi(handlePtr, srcBuffer, maxFrames);
+				result = readInterleaved(srcBuffer);
 
-				// if PCM data is available in the buffer
-				if (result > 0)
+				if (result < 0 && restore(result))
 				{
-					auto timestamp{util::Timestamp::now()};
-					auto offset{containsData(srcBuffer, static_cast<snd_pcm_uframes_t>(result))};
+					// error was recovered so keep processing
+					result = 0;
 
-					// if PCM data contains active stream
-					if (offset >= 0)
+					// this thread serves only one device so it may wait until suspended device is ready to be resumed
+					if (resuming)
 					{
-						// enqueue received PCM data so that none-Real-Time safe code can process it
-						queue.enqueue([&](Chunk& chunk)
-						{
-							// setting chunk 'meta' data
-							chunk.timestamp = timestamp;
-							chunk.samplingRate = parameters.getSamplingRate();
-							chunk.channels = parameters.getLogicalChannels();
-							chunk.bytesPerSample = parameters.getBitsPerSample() >> 3;
-							chunk.endOfStream = false;
-
-							// copying PCM data and setting chunk's payload size in frames
-							auto copiedFrames = copyData(
-								srcBuffer + offset * bytesPerFrame,
-								chunk.buffer.getData(),
-								static_cast<snd_pcm_uframes_t>(result - std::min(offset, result)));
-
-							capturedFrames += copiedFrames;
-							chunk.frames = copiedFrames;
-							chunk.capturedFrames = capturedFrames;
-
-							// only the first chunk in stream is marked as Beginning-Of-Stream
-							isBeginningOfStream = false;
-
-							// always true as source buffer contains data
-							return true;
-						}, [&]
-						{
-							// calling overflow callback in case it was not possible to enqueue a chunk
-							overflowCallback();
-						});
-					}
-					else if (!isBeginningOfStream)
-					{
-						// submitting an end-of-stream chunk to notify consumer thread about End-Of-Stream
-						queue.enqueue([&](Chunk& chunk)
-						{
-							// setting chunk 'meta' data
-							chunk.timestamp = timestamp;
-							chunk.samplingRate = parameters.getSamplingRate();
-							chunk.channels = parameters.getLogicalChannels();
-							chunk.bytesPerSample = parameters.getBitsPerSample() >> 3;
-							chunk.endOfStream = true;
-							chunk.clear();
-
-							chunk.capturedFrames = capturedFrames;
-
-							// resetting state as the next chunk will initiate a new streaming session
-							isBeginningOfStream = true;
-
-							// always true as source buffer contains data
-							return true;
-						}, [&]
-						{
-							// calling overflow callback in case it was not possible to enqueue a chunk
-							overflowCallback();
-						});
+						::poll(nullptr, 0, resumeRetryTimeout);
 					}
 				}
-				else if (result < 0 && restore(result))
+			}  // while (result >= 0)
+
+			// if error code is unexpected then breaking this loop (-EBADFD is returned when stop method is called)
+			if (result != -EBADFD)
+			{
+				LOG(ERROR) << LABELS{"alsa"} << formatError("Unexpected error while reading PCM data", result);
+			}
+		}
+
+
+		void Source::produceMemoryMapped()
+		{
+			auto result{snd_pcm_sframes_t{0}};
+
+			// everything inside this loop (except overflowCallback) must be real-time safe: no memory allocation, no logging, etc.
+			while (result >= 0)
+			{
+				// this call will block until at least avail_min frames are available or PCM stream state is changed
+				if ((result = snd_pcm_wait(handlePtr, -1)) >= 0)
+				{
+					result = readMemoryMapped();
+				}
+
+				// snd_pcm_wait does not report -EBADFD when stream was dropped by stop method, so checking the state explicitly
+				if (snd_pcm_state(handlePtr) == SND_PCM_STATE_SETUP)
+				{
+					result = -EBADFD;
+				}
+
+				if (result < 0 && result != -EBADFD && restore(result))
 				{
 					// error was recovered so keep processing
 					result = 0;
+
+					// this thread serves only one device so it may wait until suspended device is ready to be resumed
+					if (resuming)
+					{
+						::poll(nullptr, 0, resumeRetryTimeout);
+					}
 				}
 			}  // while (result >= 0)
 
@@ -282,18 +433,211 @@ namespace slim
 		}
 
 
+		snd_pcm_sframes_t Source::read()
+		{
+			return parameters.isMemoryMapped() ? readMemoryMapped() : readInterleaved(captureBuffer.getData());
+		}
+
+
+		snd_pcm_sframes_t Source::readInterleaved(unsigned char* buffer)
+		{
+			auto result{snd_pcm_readi(handlePtr, buffer, parameters.getFramesPerChunk())};
+
+			// if PCM data is available in the buffer
+			if (result > 0)
+			{
+				enqueueData(buffer, static_cast<snd_pcm_uframes_t>(result));
+			}
+
+			return result;
+		}
+
+
+		snd_pcm_sframes_t Source::readMemoryMapped()
+		{
+			auto result{snd_pcm_avail_update(handlePtr)};
+
+			// if PCM data is available in the DMA area
+			if (result > 0)
+			{
+				const snd_pcm_channel_area_t* areas;
+				snd_pcm_uframes_t             offset;
+				snd_pcm_uframes_t             frames{std::min(static_cast<snd_pcm_uframes_t>(result), parameters.getFramesPerChunk())};
+				unsigned int                  bytesPerFrame{parameters.getTotalChannels() * (parameters.getBitsPerSample() >> 3)};
+
+				// DMA area is a ring buffer so less frames than requested may be provided in case of a wrap-around
+				if ((result = snd_pcm_mmap_begin(handlePtr, &areas, &offset, &frames)) >= 0)
+				{
+					// all channels are interleaved within the first area
+					auto buffer{static_cast<unsigned char*>(areas[0].addr) + (areas[0].first >> 3) + offset * bytesPerFrame};
+
+					// marker channel is stripped while copying straight from the DMA area to the queued chunk
+					enqueueData(buffer, frames);
+
+					if (auto committed{snd_pcm_mmap_commit(handlePtr, offset, frames)}; committed < 0)
+					{
+						result = committed;
+					}
+					else if (static_cast<snd_pcm_uframes_t>(committed) != frames)
+					{
+						result = -EPIPE;
+					}
+					else
+					{
+						result = committed;
+					}
+				}
+			}
+
+			return result;
+		}
+
+
 		bool Source::restore(snd_pcm_sframes_t error)
 		{
-			auto restored{true};
+			auto result{static_cast<int>(error)};
 
-			if (error < 0)
+			// suspended device is resumed without blocking; if device is not ready yet then resuming is retried by the caller
+			if (result == -ESTRPIPE)
 			{
-				// TODO: this is where ALSA stream may be restored depending on an error and the state
-				snd_pcm_state(handlePtr);
-				restored = false;
+				if ((resuming = ((result = snd_pcm_resume(handlePtr)) == -EAGAIN)))
+				{
+					return true;
+				}
+
+				// if resuming is not supported then device is prepared from scratch
+				if (result < 0)
+				{
+					result = -EPIPE;
+				}
 			}
 
-			return restored;
+			// in case of an overrun device is prepared and started again, which discards all captured data
+			if (result == -EPIPE)
+			{
+				// device status is reset by prepare, so lost frames must be counted beforehand
+				auto lost{countLostFrames()};
+
+				if ((result = snd_pcm_prepare(handlePtr)) >= 0)
+				{
+					result = snd_pcm_start(handlePtr);
+				}
+
+				// lost frames matter only if there is an active stream
+				if (result >= 0 && !beginningOfStream)
+				{
+					pendingDroppedFrames += lost;
+					droppedFrames.fetch_add(lost, std::memory_order_relaxed);
+
+					// stream markers may have been lost within the gap, so stream state is taken from the first frame after the gap
+					resynchronizing = true;
+				}
+			}
+
+			return result >= 0;
+		}
+
+
+		void Source::start()
+		{
+			std::scoped_lock<std::mutex> lockGuard{threadLock};
+
+			// capture engine opens all devices and captures them within its own thread
+			if (captureEnginePtr)
+			{
+				if (!running)
+				{
+					running = true;
+					captureEnginePtr->start();
+				}
+				return;
+			}
+
+			if (!running)
+			{
+				running = true;
+
+				// starting PCM data producer thread for Real-Time processing
+				producerThread = std::thread{[&]
+				{
+					LOG(DEBUG) << LABELS{"slim"} << "PCM data capture thread was started (id=" << std::this_thread::get_id() << ")";
+
+					try
+					{
+						util::applyThreadSettings(parameters.getRealTimePriority(), parameters.getCPUAffinity());
+
+						// opening ALSA device in a thread-safe way
+						{
+							std::scoped_lock<std::mutex> lockGuard{deviceLock};
+							open();
+						}
+
+						// start producing
+						produce();
+					}
+					catch (const Exception& error)
+					{
+						LOG(ERROR) << LABELS{"slim"} << "Error in producer thread: " << error;
+					}
+					catch (const std::exception& error)
+					{
+						LOG(ERROR) << LABELS{"slim"} << "Error in producer thread: " << error.what();
+					}
+					catch (...)
+					{
+						LOG(ERROR) << LABELS{"slim"} << "Unexpected exception";
+					}
+
+					// closing ALSA device in a thread-safe way
+					{
+						std::scoped_lock<std::mutex> lockGuard{deviceLock};
+						close();
+					};
+
+					LOG(DEBUG) << LABELS{"slim"} << "PCM data capture thread was stopped (id=" << std::this_thread::get_id() << ")";
+				}};
+
+				// this is an optional delay for producer thread to start
+				std::this_thread::sleep_for(std::chrono::milliseconds{10});
+			}
+		}
+
+
+		void Source::stopCapture()
+		{
+			std::scoped_lock<std::mutex> lockGuard{threadLock};
+
+			// capture engine is shared, so only this source's reference is released
+			if (captureEnginePtr)
+			{
+				if (running)
+				{
+					running = false;
+					captureEnginePtr->stop();
+				}
+				return;
+			}
+
+			if (running)
+			{
+				// issuing a request to stop receiving PCM data; it is protected by deviceLock to prevent interference with open/close procedures
+				{
+					std::scoped_lock<std::mutex> lockGuard{deviceLock};
+					if (int result; handlePtr && (result = snd_pcm_drop(handlePtr)) < 0)
+					{
+						LOG(ERROR) << LABELS{"alsa"} << formatError("Error while stopping PCM stream unconditionally", result);
+					}
+				}
+
+				// changing state to 'not running'
+				running = false;
+			}
+
+			// waiting producer thread to terminate
+			if (producerThread.joinable())
+			{
+				producerThread.join();
+			}
 		}
 	}
 }
@@ -26,6 +26,7 @@
 #include <type_safe/optional.hpp>
 
 #include "slim/alsa/Parameters.hpp"
+#include "slim/alsa/StreamMarker.hpp"
 #include "slim/Chunk.hpp"
 #include "slim/Consumer.hpp"
 #include "slim/ContainerBase.hpp"
@@ -33,6 +34,8 @@
 #include "slim/log/log.hpp"
 #include "slim/util/RealTimeQueue.hpp"
 #include "slim/util/BigInteger.hpp"
+#include "slim/util/buffer/HeapBuffer.hpp"
+#include "slim/util/Timestamp.hpp"
 
 
 namespace slim
@@ -41,56 +44,86 @@ namespace slim
 	{
 		namespace ts = type_safe;
 
-		enum class StreamMarker : unsigned char
-		{
-			beginningOfStream = 1,
-			endOfStream       = 2,
-			data              = 3,
-		};
+		class CaptureEngine;
 
 		class Source
 		{
+			friend class CaptureEngine;
+
 			using QueueType = util::RealTimeQueue<Chunk>;
 
 			public:
+				// interval (in milliseconds) between attempts to resume a suspended device
+				static constexpr int resumeRetryTimeout{1};
+
+				// chunk memory is not shared so all of it is reserved by this source
 				Source(conwrap2::ProcessorProxy<std::unique_ptr<ContainerBase>> pp, Parameters pa, std::function<void()> oc = [] {})
-				: parameters{pa}
-				, overflowCallback{std::move(oc)}
-				, queue{parameters.getQueueSize(), std::move([&](Chunk& chunk)
-				{
-					// no need to store data from the last channel as it contains commands
-					chunk.allocateBuffer(pa.getFramesPerChunk() * pa.getLogicalChannels() * (pa.getBitsPerSample() >> 3));
-				})} {}
+				: Source{pp, pa, nullptr, std::make_shared<Chunk::ArenaType>(pa.getQueueSize(), getChunkSize(pa)), std::move(oc)} {}
 
-				~Source()
-				{
-					// it is safe to call stop method multiple times
-					stop([] {});
-				}
+				// device is captured by a capture engine shared between sources instead of a dedicated thread (if provided);
+				// chunk memory above the reserved minimum is borrowed from the arena only while a stream is active
+				Source(conwrap2::ProcessorProxy<std::unique_ptr<ContainerBase>> pp, Parameters pa, std::shared_ptr<CaptureEngine> ce, std::shared_ptr<Chunk::ArenaType> ca, std::function<void()> oc = [] {});
+
+				~Source();
 
 				Source(const Source&) = delete;             // non-copyable
 				Source& operator=(const Source&) = delete;  // non-assignable
 				Source(Source&& rhs) = delete;              // non-movable
 				Source& operator=(Source&& rhs) = delete;   // non-move-assignable
 
+				inline static std::size_t getChunkSize(const Parameters& pa)
+				{
+					// no need to store data from the last channel as it contains commands
+					return pa.getFramesPerChunk() * pa.getLogicalChannels() * (pa.getBitsPerSample() >> 3);
+				}
+
+				inline std::size_t getQueueCapacity() const
+				{
+					return queue.getCapacity();
+				}
+
+				inline std::size_t getQueueDepth() const
+				{
+					return queue.getReadySize();
+				}
+
+				// total amount of frames lost due to capture overruns
+				inline std::size_t getDroppedFrames() const
+				{
+					return droppedFrames.load(std::memory_order_relaxed);
+				}
+
 				inline auto getParameters()
 				{
 					return parameters;
 				}
 
+				inline bool isConsuming()
+				{
+					return consuming;
+				}
+
 				inline bool isRunning()
 				{
 					return running;
 				}
 
+				inline bool isStreaming()
+				{
+					return streaming.load(std::memory_order_relaxed);
+				}
+
 				template<typename ConsumerType>
 				inline ts::optional<std::chrono::milliseconds> produceChunk(const ConsumerType& consumer)
 				{
-					auto result{ts::optional<std::chrono::milliseconds>{ts::nullopt}};
-
-					result = producer(consumer);
+					return producer(consumer, 1);
+				}
 
-					return result;
+				// all ready chunks up to maxChunks are handed to the consumer within one pass over the queue
+				template<typename ConsumerType>
+				inline ts::optional<std::chrono::milliseconds> produceChunks(const ConsumerType& consumer, std::size_t maxChunks)
+				{
+					return producer(consumer, maxChunks);
 				}
 
 				inline ts::optional<std::chrono::milliseconds> skipChunk()
@@ -99,118 +132,75 @@ namespace slim
 					return producer([](auto&)
 					{
 						return true;
-					});
+					}, 1);
 				}
 
 				void produce();
 
-				void start()
+				// callback is invoked by the capture thread once a chunk is enqueued so it must be real-time safe
+				template<typename CallbackType>
+				inline void setEnqueueCallback(CallbackType callback)
 				{
-					std::scoped_lock<std::mutex> lockGuard{threadLock};
-					if (!running)
-					{
-						running = true;
-
-						// starting PCM data producer thread for Real-Time processing
-						producerThread = std::thread{[&]
-						{
-							LOG(DEBUG) << LABELS{"slim"} << "PCM data capture thread was started (id=" << std::this_thread::get_id() << ")";
-
-							try
-							{
-								// opening ALSA device in a thread-safe way
-								{
-									std::scoped_lock<std::mutex> lockGuard{deviceLock};
-									open();
-								}
-
-								// start producing
-								produce();
-							}
-							catch (const Exception& error)
-							{
-								LOG(ERROR) << LABELS{"slim"} << "Error in producer thread: " << error;
-							}
-							catch (const std::exception& error)
-							{
-								LOG(ERROR) << LABELS{"slim"} << "Error in producer thread: " << error.what();
-							}
-							catch (...)
-							{
-								LOG(ERROR) << LABELS{"slim"} << "Unexpected exception";
-							}
-
-							// closing ALSA device in a thread-safe way
-							{
-								std::scoped_lock<std::mutex> lockGuard{deviceLock};
-								close();
-							};
-
-							LOG(DEBUG) << LABELS{"slim"} << "PCM data capture thread was stopped (id=" << std::this_thread::get_id() << ")";
-						}};
-
-						// this is an optional delay for producer thread to start
-						std::this_thread::sleep_for(std::chrono::milliseconds{10});
-					}
+					enqueueCallback = std::move(callback);
 				}
 
+				void start();
+
 				template<typename CallbackType>
 				inline void stop(CallbackType callback)
 				{
-					{
-						std::scoped_lock<std::mutex> lockGuard{threadLock};
-						if (running)
-						{
-							// issuing a request to stop receiving PCM data; it is protected by deviceLock to prevent interference with open/close procedures
-							{
-								std::scoped_lock<std::mutex> lockGuard{deviceLock};
-								if (int result; (result = snd_pcm_drop(handlePtr)) < 0)
-								{
-									LOG(ERROR) << LABELS{"alsa"} << formatError("Error while stopping PCM stream unconditionally", result);
-								}
-							}
-
-							// changing state to 'not running'
-							running = false;
-						}
-
-						// waiting producer thread to terminate
-						if (producerThread.joinable())
-						{
-							producerThread.join();
-						}
-					}
-
+					stopCapture();
 					callback();
 				}
 
 			protected:
 				void              close() noexcept;
+				snd_pcm_uframes_t countLostFrames();
 				snd_pcm_sframes_t containsData(unsigned char* buffer, snd_pcm_uframes_t frames);
 				snd_pcm_uframes_t copyData(unsigned char* srcBuffer, unsigned char* dstBuffer, snd_pcm_uframes_t frames);
+				void              enqueueData(unsigned char* buffer, snd_pcm_uframes_t frames);
 
 				inline std::string formatError(std::string message, int error = 0)
 				{
 					return message + ": name='" + parameters.getDeviceName() + (error != 0 ? std::string{"' error='"} + snd_strerror(error) + "'" : "");
 				}
 
-				void open();
+				void              open();
+				void              produceInterleaved();
+				void              produceMemoryMapped();
+				snd_pcm_sframes_t read();
+				snd_pcm_sframes_t readInterleaved(unsigned char* buffer);
+				snd_pcm_sframes_t readMemoryMapped();
 
 				template<typename ConsumerType>
-				inline ts::optional<std::chrono::milliseconds> producer(const ConsumerType& consumer)
+				inline ts::optional<std::chrono::milliseconds> producer(const ConsumerType& consumer, std::size_t maxChunks)
 				{
 					auto result{ts::optional<std::chrono::milliseconds>{ts::nullopt}};
 
-					queue.dequeue(std::move([&](Chunk& chunk) -> bool  // 'mover' function
+					queue.dequeueBatch(maxChunks, [&](Chunk* chunks, std::size_t count)  // 'mover' function
 					{
-						auto consumed{false};
+						auto consumed{std::size_t{0}};
 
 						consuming = true;
 
-						// feeding consumer with a chunk
-						if (consumer(chunk))
+						// feeding consumer with chunks until it defers processing
+						for (; consumed < count; consumed++)
 						{
-							consumed = true;
+							auto& chunk{chunks[consumed]};
+
+							if (!consumer(chunk))
+							{
+								// if consumer did not accept a chunk then waiting until it signals that it is ready again
+								result.reset();
+								break;
+							}
+
+							// returning memory above the reserved minimum so that other sources may use it
+							if (chunk.buffer.getData() && heldChunks.load(std::memory_order_relaxed) > parameters.getReservedChunks())
+							{
+								chunk.buffer = Chunk::BufferType{};
+								heldChunks.fetch_sub(1, std::memory_order_relaxed);
+							}
 
 							// if chunk was consumed and it is the end of the stream
 							if (chunk.endOfStream)
@@ -222,40 +212,43 @@ namespace slim
 								result = 0;
 							}
 						}
-						else
-						{
-							// if consumer did not accept a chunk then deferring further processing
-							// TODO: cruise control should be implemented
-							result = 10;
-						}
 
 						return consumed;
-					}), std::move([&]  // underflow callback
+					}, [&]  // underflow callback
 					{
-						if (consuming)
-						{
-							result = 10;
-						}
-					}));
+						// returning no value, enqueue callback will signal once there is a new chunk
+					});
 
 					// if there are more chunks to be consumed
 					return result;
 				}
 
 				bool restore(snd_pcm_sframes_t error);
+				void stopCapture();
 
 			private:
-				Parameters            parameters;
-				std::function<void()> overflowCallback;
-				std::thread           producerThread;
-				QueueType             queue;
-				snd_pcm_t*            handlePtr{nullptr};
-				std::atomic<bool>     running{false};
-				bool                  producing{false};
-				bool                  consuming{false};
-				std::mutex            deviceLock;
-				std::mutex            threadLock;
-				util::BigInteger      capturedFrames{0};
+				Parameters                             parameters;
+				std::shared_ptr<CaptureEngine>         captureEnginePtr;
+				std::shared_ptr<Chunk::ArenaType>      chunkArenaPtr;
+				std::atomic<std::size_t>               heldChunks{0};
+				std::function<void()>                  overflowCallback;
+				std::function<void()>                  enqueueCallback{[] {}};
+				std::thread                            producerThread;
+				QueueType                              queue;
+				util::buffer::HeapBuffer<std::uint8_t> captureBuffer{0};
+				snd_pcm_t*                             handlePtr{nullptr};
+				std::atomic<bool>                      running{false};
+				std::atomic<bool>                      streaming{false};
+				bool                                   beginningOfStream{true};
+				bool                                   producing{false};
+				bool                                   resynchronizing{false};
+				bool                                   resuming{false};
+				bool                                   consuming{false};
+				std::mutex                             deviceLock;
+				std::mutex                             threadLock;
+				util::BigInteger                       capturedFrames{0};
+				std::size_t                            pendingDroppedFrames{0};
+				std::atomic<std::size_t>               droppedFrames{0};
 		};
 	}
 }
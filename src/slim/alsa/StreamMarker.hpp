@@ -0,0 +1,28 @@
+/*
+ * Copyright 2017, Andrej Kislovskij
+ *
+ * This is PUBLIC DOMAIN software so use at your own risk as it comes
+ * with no warranties. This code is yours to share, use and modify without
+ * any restrictions or obligations.
+ *
+ * For more information see conwrap/LICENSE or refer refer to http://unlicense.org
+ *
+ * Author: gimesketvirtadieni at gmail dot com (Andrej Kislovskij)
+ */
+
+#pragma once
+
+
+namespace slim
+{
+	namespace alsa
+	{
+		// stream marker is passed in the most significant byte of the last channel of every frame
+		enum class StreamMarker : unsigned char
+		{
+			beginningOfStream = 1,
+			endOfStream       = 2,
+			data              = 3,
+		};
+	}
+}
@@ -0,0 +1,137 @@
+/*
+ * Copyright 2017, Andrej Kislovskij
+ *
+ * This is PUBLIC DOMAIN software so use at your own risk as it comes
+ * with no warranties. This code is yours to share, use and modify without
+ * any restrictions or obligations.
+ *
+ * For more information see conwrap/LICENSE or refer refer to http://unlicense.org
+ *
+ * Author: gimesketvirtadieni at gmail dot com (Andrej Kislovskij)
+ */
+
+#pragma once
+
+#include <experimental/net>
+#include <cstddef>    // std::size_t
+#include <exception>  // std::exception
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "slim/log/log.hpp"
+
+
+namespace slim
+{
+	namespace conn
+	{
+		// a fixed set of I/O threads, each running its own io_context; sockets are bound to one context for their lifetime
+		class IOThreadPool
+		{
+			using WorkGuardType = std::experimental::net::executor_work_guard<std::experimental::net::io_context::executor_type>;
+
+			public:
+				IOThreadPool(std::size_t size)
+				{
+					for (std::size_t i{0}; i < (size > 0 ? size : 1); i++)
+					{
+						contexts.push_back(std::make_unique<std::experimental::net::io_context>(1));
+					}
+				}
+
+				~IOThreadPool()
+				{
+					stop();
+				}
+
+				IOThreadPool(const IOThreadPool&) = delete;             // non-copyable
+				IOThreadPool& operator=(const IOThreadPool&) = delete;  // non-assignable
+				IOThreadPool(IOThreadPool&& rhs) = delete;              // non-movable
+				IOThreadPool& operator=(IOThreadPool&& rhs) = delete;   // non-move-assignable
+
+				// contexts are handed out round-robin; must be called from one thread (the processor thread)
+				inline auto& getContext()
+				{
+					auto& context{*contexts[next]};
+					next = (next + 1) % contexts.size();
+
+					return context;
+				}
+
+				inline auto getSize() const
+				{
+					return contexts.size();
+				}
+
+				void start()
+				{
+					if (!threads.empty())
+					{
+						return;
+					}
+
+					for (auto& contextPtr : contexts)
+					{
+						// work guard keeps io_context running while there are no pending socket operations
+						contextPtr->restart();
+						workGuards.emplace_back(std::experimental::net::make_work_guard(*contextPtr));
+
+						threads.emplace_back([&context = *contextPtr]
+						{
+							LOG(DEBUG) << LABELS{"conn"} << "I/O thread was started (id=" << std::this_thread::get_id() << ")";
+
+							for (auto done{false}; !done;)
+							{
+								try
+								{
+									context.run();
+									done = true;
+								}
+								catch (const std::exception& error)
+								{
+									LOG(ERROR) << LABELS{"conn"} << "Error in I/O thread: " << error.what();
+								}
+								catch (...)
+								{
+									LOG(ERROR) << LABELS{"conn"} << "Unexpected exception";
+								}
+							}
+
+							LOG(DEBUG) << LABELS{"conn"} << "I/O thread was stopped (id=" << std::this_thread::get_id() << ")";
+						});
+					}
+
+					LOG(INFO) << LABELS{"conn"} << "I/O thread pool was started (threads=" << threads.size() << ")";
+				}
+
+				void stop()
+				{
+					if (threads.empty())
+					{
+						return;
+					}
+
+					// connections must be disposed by now, so there are no handlers worth waiting for
+					workGuards.clear();
+					for (auto& contextPtr : contexts)
+					{
+						contextPtr->stop();
+					}
+					for (auto& thread : threads)
+					{
+						thread.join();
+					}
+					threads.clear();
+
+					LOG(INFO) << LABELS{"conn"} << "I/O thread pool was stopped";
+				}
+
+			private:
+				std::vector<std::unique_ptr<std::experimental::net::io_context>> contexts;
+				std::vector<WorkGuardType>                                       workGuards;
+				std::vector<std::thread>                                         threads;
+				std::size_t                                                      next{0};
+		};
+	}
+}
@@ -15,8 +15,12 @@
 #include <conwrap2/ProcessorProxy.hpp>
 #include <cstddef>       // std::size_t
 #include <exception>     // std::exception
+#include <cstdint>       // std::u..._t types
+#include <functional>
 #include <memory>
 #include <system_error>  // std::system_error
+#include <utility>       // std::move
+#include <vector>
 
 #include "slim/conn/tcp/CallbacksBase.hpp"
 #include "slim/log/log.hpp"
@@ -31,22 +35,38 @@ namespace slim
 	{
 		namespace tcp
 		{
+			// socket may be bound to an I/O thread context (sharded connection); in that case socket operations are performed
+			// by the I/O thread while all callbacks are still delivered to the processor thread, so protocol logic stays single-threaded
 			template <typename ContainerType>
 			class Connection : public util::AsyncWriter
 			{
+				using ProcessorProxyType = conwrap2::ProcessorProxy<std::unique_ptr<ContainerBase>>;
+
 				public:
-					Connection(conwrap2::ProcessorProxy<std::unique_ptr<ContainerBase>> p, CallbacksBase<Connection<ContainerType>>& c)
+					Connection(ProcessorProxyType p, CallbacksBase<Connection<ContainerType>>& c)
+					: Connection{p, c, p.getDispatcher()} {}
+
+					Connection(ProcessorProxyType p, CallbacksBase<Connection<ContainerType>>& c, std::experimental::net::io_context& sc)
 					: processorProxy{p}
 					, callbacks{c}
-					, nativeSocket{processorProxy.getDispatcher()}
+					, socketContext{sc}
+					, sharded{&socketContext != &processorProxy.getDispatcher()}
+					, socketPtr{std::make_shared<Socket>(socketContext)}
 					, opened{false}
 					{
-						LOG(DEBUG) << LABELS{"conn"} << "Connection object was created (id=" << this << ")";
+						LOG(DEBUG) << LABELS{"conn"} << "Connection object was created (id=" << this << ", sharded=" << sharded << ")";
 					}
 
 					virtual ~Connection()
 					{
-						stop();
+						// handlers that are still in flight must not reach this object
+						alivePtr.reset();
+
+						// socket is shared with handlers which may be still in flight, so it is closed without waiting for them
+						onSocketThread([socketPtr = socketPtr]
+						{
+							close(*socketPtr);
+						});
 
 						LOG(DEBUG) << LABELS{"conn"} << "Connection object was deleted (id=" << this << ")";
 					}
@@ -56,9 +76,14 @@ namespace slim
 					Connection(Connection&& rhs) = delete;              // non-movable
 					Connection& operator=(Connection&& rhs) = delete;   // non-movable-assignable
 
+					inline auto getActiveIndex() const
+					{
+						return activeIndex;
+					}
+
 					inline auto& getNativeSocket()
 					{
-						return nativeSocket;
+						return socketPtr->nativeSocket;
 					}
 
 					inline auto isOpen()
@@ -66,37 +91,66 @@ namespace slim
 						return opened;
 					}
 
+					// prepares a stopped connection to be reused for accepting a new client; callback is invoked by the processor
+					// thread once the socket is closed by the socket thread, so the processor thread never waits for the I/O thread
+					void reset(std::function<void()> callback)
+					{
+						// handlers which are still in flight belong to the previous client
+						alivePtr = std::make_shared<bool>(true);
+						opened   = false;
+
+						onSocketThread([processorProxy = processorProxy, sharded = sharded, socketPtr = socketPtr, alive = std::weak_ptr<bool>{alivePtr}, callback = std::move(callback)]() mutable
+						{
+							close(*socketPtr);
+
+							onProcessorThread(processorProxy, sharded, [alive, callback = std::move(callback)]
+							{
+								if (alive.lock())
+								{
+									callback();
+								}
+							});
+						});
+					}
+
 					virtual void rewind(const std::streampos pos) override {}
 
+					inline void setActiveIndex(std::size_t i)
+					{
+						activeIndex = i;
+					}
+
 					void setNoDelay(bool noDelay)
 					{
 						// enabling / disabling Nagle's algorithm
-						nativeSocket.set_option(std::experimental::net::ip::tcp::no_delay{noDelay});
+						socketPtr->nativeSocket.set_option(std::experimental::net::ip::tcp::no_delay{noDelay});
 					}
 
 					void setQuickAcknowledgment(bool quickAcknowledgment)
 					{
 						const std::experimental::net::detail::socket_option::boolean<IPPROTO_TCP, TCP_QUICKACK> quickack{quickAcknowledgment};
-						nativeSocket.set_option(quickack);
+						socketPtr->nativeSocket.set_option(quickack);
 					}
 
 					void start(std::experimental::net::ip::tcp::acceptor& acceptor)
 					{
 						onStart();
 
+						// acceptor belongs to the processor thread, so accept handler is invoked by the processor thread
 						acceptor.async_accept(
+							socketContext,
 							[&](auto error, auto s)
 							{
 								// TODO: figure out a better alternative in case when error != 0
-								nativeSocket = std::move(s);
+								socketPtr->nativeSocket = std::move(s);
 
 								if (!error)
 								{
 									// making sure synchronous operations do not throw would_block exception
-									nativeSocket.non_blocking(false);
+									socketPtr->nativeSocket.non_blocking(false);
 
 									// making sure keep-alive packets are sent
-									nativeSocket.set_option(std::experimental::net::socket_base::keep_alive{true});
+									socketPtr->nativeSocket.set_option(std::experimental::net::socket_base::keep_alive{true});
 								}
 
 								onOpen(error);
@@ -107,16 +161,10 @@ namespace slim
 					void stop()
 					{
 						// it will trigger chain of callbacks
-						if (nativeSocket.is_open()) try
-						{
-							nativeSocket.shutdown(std::experimental::net::socket_base::shutdown_both);
-						}
-						catch(...) {}
-						try
+						onSocketThread([socketPtr = socketPtr]
 						{
-							nativeSocket.close();
-						}
-						catch(...) {}
+							close(*socketPtr);
+						});
 					}
 
 					// including write overloads
@@ -126,9 +174,17 @@ namespace slim
 					{
 						std::size_t result{0};
 
-						if (nativeSocket.is_open()) try
+						// processor thread must not wait for the socket thread, so data is copied and sent asynchronously
+						if (sharded && !socketContext.get_executor().running_in_this_thread())
+						{
+							auto bufferPtr{std::make_shared<std::vector<std::uint8_t>>(static_cast<const std::uint8_t*>(data), static_cast<const std::uint8_t*>(data) + size)};
+							writeAsync(bufferPtr->data(), bufferPtr->size(), [bufferPtr](auto, auto, auto) {});
+
+							result = size;
+						}
+						else if (socketPtr->nativeSocket.is_open()) try
 						{
-							result = std::experimental::net::write(nativeSocket, std::experimental::net::const_buffer(data, size));
+							result = std::experimental::net::write(socketPtr->nativeSocket, std::experimental::net::const_buffer(data, size));
 						}
 						catch(const std::system_error& e)
 						{
@@ -145,36 +201,104 @@ namespace slim
 					// including writeAsync overloads
 					using AsyncWriter::writeAsync;
 
-					virtual void writeAsync(const void* data, const std::size_t size, util::WriteCallback callback = [](auto, auto) {}) override
+					virtual void writeAsync(const void* data, const std::size_t size, util::WriteCallback callback = [](auto, auto, auto) {}) override
 					{
-						if (nativeSocket.is_open())
+						onSocketThread([id = this, data, size, socketPtr = socketPtr, handler = createWriteHandler(std::move(callback))]() mutable
 						{
-							std::experimental::net::async_write(
-								nativeSocket,
-								std::experimental::net::const_buffer(data, size),
-								[=](const std::error_code error, const std::size_t bytes_transferred)
-								{
-									callback(error, bytes_transferred);
-								});
+							if (socketPtr->nativeSocket.is_open())
+							{
+								std::experimental::net::async_write(
+									socketPtr->nativeSocket,
+									std::experimental::net::const_buffer(data, size),
+									std::move(handler));
+							}
+							else
+							{
+								LOG(DEBUG) << LABELS{"conn"} << "Could not send data as socket is not opened (id=" << id << ")";
+
+								// calling callback even if socket is closed
+								handler(std::error_code{std::experimental::net::error::not_connected}, 0);
+							}
+						});
+					}
+
+					virtual void writeAsync(const util::WriteBuffers& buffers, util::WriteCallback callback = [](auto, auto, auto) {}) override
+					{
+						// all buffers are submitted as one sequence, so they are sent with as few (writev) system calls as possible
+						std::vector<std::experimental::net::const_buffer> sequence;
+						sequence.reserve(buffers.size());
+						for (auto& buffer : buffers)
+						{
+							sequence.emplace_back(buffer.data, buffer.size);
 						}
-						else
+
+						onSocketThread([id = this, sequence = std::move(sequence), socketPtr = socketPtr, handler = createWriteHandler(std::move(callback))]() mutable
 						{
-							LOG(DEBUG) << LABELS{"conn"} << "Could not send data as socket is not opened (id=" << this << ")";
+							if (socketPtr->nativeSocket.is_open())
+							{
+								std::experimental::net::async_write(
+									socketPtr->nativeSocket,
+									std::move(sequence),
+									std::move(handler));
+							}
+							else
+							{
+								LOG(DEBUG) << LABELS{"conn"} << "Could not send data as socket is not opened (id=" << id << ")";
 
-							// calling callback even if socket is closed
-							callback(std::error_code{std::experimental::net::error::not_connected}, 0);
-						}
+								// calling callback even if socket is closed
+								handler(std::error_code{std::experimental::net::error::not_connected}, 0);
+							}
+						});
 					}
 
 				protected:
+					// socket and receive buffer are shared with handlers running on the socket thread, so this connection may be
+					// disposed or reused without waiting for them
+					struct Socket
+					{
+						Socket(std::experimental::net::io_context& c)
+						: nativeSocket{c} {}
+
+						std::experimental::net::ip::tcp::socket nativeSocket;
+						// TODO: parametrize
+						util::buffer::HeapBuffer<std::uint8_t>  buffer{1024};
+					};
+
+					static void close(Socket& socket)
+					{
+						if (socket.nativeSocket.is_open()) try
+						{
+							socket.nativeSocket.shutdown(std::experimental::net::socket_base::shutdown_both);
+						}
+						catch(...) {}
+						try
+						{
+							socket.nativeSocket.close();
+						}
+						catch(...) {}
+					}
+
+					inline auto createWriteHandler(util::WriteCallback callback)
+					{
+						// write handler is invoked by the socket thread and it must not refer to this connection; timestamp is taken by
+						// the socket thread, so it is not affected by the delay of handing callback over to the processor thread
+						return [processorProxy = processorProxy, sharded = sharded, callback = std::move(callback)](const std::error_code error, const std::size_t bytes_transferred) mutable
+						{
+							onProcessorThread(processorProxy, sharded, [=, timestamp = util::Timestamp::now()]
+							{
+								callback(error, bytes_transferred, timestamp);
+							});
+						};
+					}
+
 					void onClose(const std::error_code error)
 					{
-						// invoking close callback before connection is desposed and setting opened status
+						// resetting opened status before invoking close callback, so the callback sees this connection as closed
 						if (opened)
 						{
+							opened = false;
 							callbacks.getCloseCallback()(*this);
 						}
-						opened = false;
 
 						// stopping this connection after it's been closed
 						onStop();
@@ -194,23 +318,17 @@ namespace slim
 							// calling onData callback that does all the usefull work
 							if (receivedSize > 0)
 							{
-								callbacks.getDataCallback()(*this, buffer.getData(), receivedSize, timestamp);
+								callbacks.getDataCallback()(*this, socketPtr->buffer.getData(), receivedSize, timestamp);
 							}
 
-							// keep receiving data
-							nativeSocket.async_read_some(
-								std::experimental::net::mutable_buffer(buffer.getData(), buffer.getSize()),
-								[&](const std::error_code error, std::size_t bytes_transferred)
-								{
-									onData(error, bytes_transferred, util::Timestamp());
-								}
-							);
+							// keep receiving data; buffer is reused only after received data was consumed by the callback
+							receive();
 						}
 					}
 
 					void onOpen(const std::error_code error)
 					{
-						if (error || !nativeSocket.is_open())
+						if (error || !socketPtr->nativeSocket.is_open())
 						{
 							onClose(error);
 						}
@@ -238,6 +356,26 @@ namespace slim
 						LOG(DEBUG) << LABELS{"conn"} << "Connection was started (id=" << this << ")";
 					}
 
+					template <typename FunctionType>
+					static void onProcessorThread(ProcessorProxyType& processorProxy, bool sharded, FunctionType function)
+					{
+						if (sharded)
+						{
+							processorProxy.process(std::move(function));
+						}
+						else
+						{
+							function();
+						}
+					}
+
+					template <typename FunctionType>
+					inline void onSocketThread(FunctionType function)
+					{
+						// socket objects are not thread-safe, so all operations are performed by the thread running socket's context
+						std::experimental::net::dispatch(socketContext, std::move(function));
+					}
+
 					void onStop()
 					{
 						// connection cannot be removed here so submitting a handler with a callback
@@ -250,13 +388,38 @@ namespace slim
 						LOG(DEBUG) << LABELS{"conn"} << "Connection was stopped (id=" << this << ")";
 					}
 
+					void receive()
+					{
+						// completion handler is invoked by the socket thread, hence it must not refer to this connection directly;
+						// socket is captured to keep the receive buffer valid until reading is completed
+						auto handler{[&, processorProxy = processorProxy, sharded = sharded, socketPtr = socketPtr, alive = std::weak_ptr<bool>{alivePtr}](const std::error_code error, std::size_t bytes_transferred) mutable
+						{
+							onProcessorThread(processorProxy, sharded, [&, alive, error, bytes_transferred, timestamp = util::Timestamp()]
+							{
+								if (alive.lock())
+								{
+									onData(error, bytes_transferred, timestamp);
+								}
+							});
+						}};
+
+						onSocketThread([socketPtr = socketPtr, handler = std::move(handler)]() mutable
+						{
+							socketPtr->nativeSocket.async_read_some(
+								std::experimental::net::mutable_buffer(socketPtr->buffer.getData(), socketPtr->buffer.getSize()),
+								std::move(handler));
+						});
+					}
+
 				private:
-					conwrap2::ProcessorProxy<std::unique_ptr<ContainerBase>> processorProxy;
-					CallbacksBase<Connection<ContainerType>>&                callbacks;
-					std::experimental::net::ip::tcp::socket                  nativeSocket;
-					bool                                                     opened;
-					// TODO: parametrize
-					util::buffer::HeapBuffer<std::uint8_t>                   buffer{1024};
+					ProcessorProxyType                        processorProxy;
+					CallbacksBase<Connection<ContainerType>>& callbacks;
+					std::experimental::net::io_context&       socketContext;
+					bool                                      sharded;
+					std::shared_ptr<Socket>                   socketPtr;
+					bool                                      opened;
+					std::shared_ptr<bool>                     alivePtr{std::make_shared<bool>(true)};
+					std::size_t                               activeIndex{0};
 			};
 		}
 	}
@@ -13,12 +13,15 @@
 #pragma once
 
 #include <experimental/net>
+#include <atomic>
 #include <conwrap2/ProcessorProxy.hpp>
 #include <cstddef>  // std::size_t
 #include <memory>
 #include <type_safe/optional.hpp>
+#include <type_safe/optional_ref.hpp>
 #include <vector>
 
+#include "slim/conn/IOThreadPool.hpp"
 #include "slim/conn/tcp/Callbacks.hpp"
 #include "slim/conn/tcp/Connection.hpp"
 #include "slim/log/log.hpp"
@@ -37,10 +40,11 @@ namespace slim
 			class Server
 			{
 				public:
-					Server(conwrap2::ProcessorProxy<std::unique_ptr<ContainerBase>> pp, unsigned int po, unsigned int ma, std::unique_ptr<Callbacks<ContainerType>> ca)
+					Server(conwrap2::ProcessorProxy<std::unique_ptr<ContainerBase>> pp, unsigned int po, unsigned int ma, std::unique_ptr<Callbacks<ContainerType>> ca, ts::optional_ref<IOThreadPool> ip = ts::nullopt)
 					: processorProxy{pp}
 					, port{po}
 					, maxConnections{ma}
+					, ioThreadPool{ip}
 					, callbacksPtr{std::make_unique<Callbacks<ContainerType>>()}
 					, started{false}
 					{
@@ -66,20 +70,17 @@ namespace slim
 								LOG(ERROR) << LABELS{"conn"} << "Error while invoking 'on open' callback (id=" << this << ", error=" << e.what() << ")";
 							}
 
-							// for whatever / unknown reason std::count_if returns signed!!! result, hence a type cast is required
-							auto foundTotal{std::count_if(connections.begin(), connections.end(), [&](auto& connectionPtr)
-							{
-								return connectionPtr->isOpen();
-							})};
+							// open connections are counted by open / close callbacks, so accepting does not depend on amount of connections
+							auto openedTotal{++openedConnections};
 
 							// registering a new connection if capacity allows so new requests can be accepted
-							if (foundTotal <= 0 || static_cast<unsigned int>(foundTotal) < maxConnections)
+							if (openedTotal < maxConnections)
 							{
 								addConnection();
 							}
 							else
 							{
-								LOG(WARNING) << LABELS{"conn"} << "Limit of active connections was reached (id=" << this << ", connections=" << connections.size() << " max=" << maxConnections << ")";
+								LOG(WARNING) << LABELS{"conn"} << "Limit of active connections was reached (id=" << this << ", connections=" << activeConnections.size() << " max=" << maxConnections << ")";
 								stopAcceptor();
 							}
 						}));
@@ -104,6 +105,9 @@ namespace slim
 							{
 								LOG(ERROR) << LABELS{"conn"} << "Error while invoking 'on close' callback (id=" << this << ", error=" << e.what() << ")";
 							}
+
+							// close callback is invoked only for connections which were opened
+							openedConnections--;
 						}));
 						callbacksPtr->setStopCallback(std::move([&, stopCallback = std::move(ca->getStopCallback())](auto& connection)
 						{
@@ -145,7 +149,7 @@ namespace slim
 
 					void start()
 					{
-						LOG(INFO) << LABELS{"conn"} << "Starting TCP new server (id=" << this << ", port=" << port << ", max connections=" << maxConnections << ")...";
+						LOG(INFO) << LABELS{"conn"} << "Starting TCP new server (id=" << this << ", port=" << port << ", max connections=" << maxConnections << ", I/O threads=" << (ioThreadPool.has_value() ? ioThreadPool.value().getSize() : 0) << ")...";
 
 						// start accepting new requests
 						startAcceptor();
@@ -164,7 +168,7 @@ namespace slim
 						stopAcceptor();
 
 						// closing active connections; connection will be removed by onStop callback
-						for (auto& connectionPtr : connections)
+						for (auto* connectionPtr : activeConnections)
 						{
 							connectionPtr->stop();
 						}
@@ -175,32 +179,53 @@ namespace slim
 				protected:
 					auto& addConnection()
 					{
-						// creating new connection
-						auto connectionPtr{std::make_unique<Connection<ContainerType>>(processorProxy, *callbacksPtr.get())};
+						Connection<ContainerType>* c{nullptr};
 
-						// start accepting connection
-						connectionPtr->start(*acceptorPtr);
+						// reusing a stopped connection if there is one, so accepting a client does not allocate
+						if (!freeConnections.empty())
+						{
+							c = freeConnections.back();
+							freeConnections.pop_back();
+						}
+						else
+						{
+							// creating new connection; its socket is served by one of the I/O threads if a pool is provided
+							auto& socketContext{ioThreadPool.has_value() ? ioThreadPool.value().getContext() : processorProxy.getDispatcher()};
+							connectionsSlab.push_back(std::make_unique<Connection<ContainerType>>(processorProxy, *callbacksPtr.get(), socketContext));
+							c = connectionsSlab.back().get();
+						}
 
-						// required to return to the caller
-						auto* c = connectionPtr.get();
+						// adding connection to the active list; connection keeps its position so it can be removed in O(1)
+						c->setActiveIndex(activeConnections.size());
+						activeConnections.push_back(c);
 
-						// adding connection to the connection vector
-						connections.push_back(std::move(connectionPtr));
+						// start accepting connection
+						c->start(*acceptorPtr);
 
-						LOG(INFO) << LABELS{"conn"} << "New connection was added (id=" << c << ", connections=" << connections.size() << ")";
+						LOG(INFO) << LABELS{"conn"} << "New connection was added (id=" << c << ", connections=" << activeConnections.size() << ")";
 
 						return *c;
 					}
 
 					void removeConnection(Connection<ContainerType>& connection)
 					{
-						// removing connection from the vector
-						connections.erase(std::remove_if(connections.begin(), connections.end(), [&](auto& connectionPtr) -> bool
+						auto index{connection.getActiveIndex()};
+
+						if (index < activeConnections.size() && activeConnections[index] == &connection)
 						{
-							return connectionPtr.get() == &connection;
-						}), connections.end());
+							// moving the last active connection in place of the removed one
+							activeConnections[index] = activeConnections.back();
+							activeConnections[index]->setActiveIndex(index);
+							activeConnections.pop_back();
+
+							// connection is kept in the slab and it is reused only once its socket is closed by the socket thread
+							connection.reset([&]
+							{
+								freeConnections.push_back(&connection);
+							});
+						}
 
-						LOG(INFO) << LABELS{"conn"} << "Connection was removed (connections=" << connections.size() << ")";
+						LOG(INFO) << LABELS{"conn"} << "Connection was removed (connections=" << activeConnections.size() << ")";
 					}
 
 					void startAcceptor()
@@ -238,10 +263,14 @@ namespace slim
 					conwrap2::ProcessorProxy<std::unique_ptr<ContainerBase>>   processorProxy;
 					unsigned int                                               port;
 					unsigned int                                               maxConnections;
+					ts::optional_ref<IOThreadPool>                             ioThreadPool;
 					std::unique_ptr<Callbacks<ContainerType>>                  callbacksPtr;
 					bool                                                       started;
 					std::unique_ptr<std::experimental::net::ip::tcp::acceptor> acceptorPtr;
-					std::vector<std::unique_ptr<Connection<ContainerType>>>    connections;
+					std::vector<std::unique_ptr<Connection<ContainerType>>>    connectionsSlab;
+					std::vector<Connection<ContainerType>*>                    activeConnections;
+					std::vector<Connection<ContainerType>*>                    freeConnections;
+					std::atomic<unsigned int>                                  openedConnections{0};
 			};
 		}
 	}
@@ -148,7 +148,7 @@ namespace slim
 					// including writeAsync overloads
 					using AsyncWriter::writeAsync;
 
-					virtual void writeAsync(const void* data, const std::size_t size, util::WriteCallback callback = [](auto, auto) {}) override
+					virtual void writeAsync(const void* data, const std::size_t size, util::WriteCallback callback = [](auto, auto, auto) {}) override
 					{
 						// TODO: to implement
 					}
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2017, Andrej Kislovskij
+ *
+ * This is PUBLIC DOMAIN software so use at your own risk as it comes
+ * with no warranties. This code is yours to share, use and modify without
+ * any restrictions or obligations.
+ *
+ * For more information see conwrap/LICENSE or refer refer to http://unlicense.org
+ *
+ * Author: gimesketvirtadieni at gmail dot com (Andrej Kislovskij)
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>  // std::size_t
+#include <mutex>
+
+#include "slim/log/log.hpp"
+#include "slim/util/Duration.hpp"
+
+
+namespace slim
+{
+	namespace flac
+	{
+		struct CompressionStats
+		{
+			unsigned int   level{0};           // compression level to be used by the next stream
+			unsigned int   load{0};            // encoding time of the last stream as a percentage of its real-time duration
+			std::size_t    streams{0};         // streams which were long enough to be measured
+			util::Duration encodingTime{0};    // time spent encoding the last stream
+			util::Duration streamDuration{0};  // real-time duration of the last stream
+		};
+
+		// compression level can not be changed while a stream is encoded, so it is adapted between streams
+		class CompressionController
+		{
+			public:
+				// budget is the max share of real-time (in percent) an encoder is allowed to spend encoding a stream;
+				// streams shorter than min stream duration are not measured
+				CompressionController(unsigned int mn, unsigned int mx, unsigned int bu, util::Duration ms)
+				: minLevel{mn}
+				, maxLevel{mx}
+				, budget{bu}
+				, minStreamDuration{ms}
+				{
+					stats.level = minLevel;
+				}
+
+				// using Rule Of Zero
+				~CompressionController() = default;
+				CompressionController(const CompressionController&) = delete;             // non-copyable
+				CompressionController& operator=(const CompressionController&) = delete;  // non-assignable
+				CompressionController(CompressionController&& rhs) = delete;              // non-movable
+				CompressionController& operator=(CompressionController&& rhs) = delete;   // non-move-assignable
+
+				inline auto getLevel()
+				{
+					std::lock_guard<std::mutex> lock{statsLock};
+
+					return stats.level;
+				}
+
+				inline auto getStats()
+				{
+					std::lock_guard<std::mutex> lock{statsLock};
+
+					return stats;
+				}
+
+				// encoders report from the thread which stops them, which is not necessarily the processor thread
+				inline void update(util::Duration encodingTime, util::Duration streamDuration)
+				{
+					std::lock_guard<std::mutex> lock{statsLock};
+
+					// short streams do not provide a representative measurement
+					if (streamDuration < minStreamDuration)
+					{
+						return;
+					}
+
+					auto previousLevel{stats.level};
+
+					stats.load           = static_cast<unsigned int>((encodingTime.count() * 100) / streamDuration.count());
+					stats.encodingTime   = encodingTime;
+					stats.streamDuration = streamDuration;
+					stats.streams++;
+
+					// the next level may cost up to twice as much, so level is increased only if there is enough headroom
+					if (stats.load > budget && stats.level > minLevel)
+					{
+						stats.level--;
+					}
+					else if (stats.load * 2 < budget && stats.level < maxLevel)
+					{
+						stats.level++;
+					}
+
+					LOG(INFO) << LABELS{"flac"} << "Compression stats (load=" << stats.load
+						<< "%, budget=" << budget
+						<< "%, encoding time=" << stats.encodingTime.count()
+						<< "us, stream duration=" << stats.streamDuration.count()
+						<< "us, level=" << previousLevel << "->" << stats.level << ")";
+				}
+
+			private:
+				unsigned int     minLevel;
+				unsigned int     maxLevel;
+				unsigned int     budget;
+				util::Duration   minStreamDuration;
+				std::mutex       statsLock;
+				CompressionStats stats;
+		};
+	}
+}
@@ -14,11 +14,17 @@
 
 #include <cstddef>   // std::size_t
 #include <FLAC++/encoder.h>
+#include <memory>
 #include <string>
 
 #include "slim/EncoderBase.hpp"
 #include "slim/Exception.hpp"
+#include "slim/flac/CompressionController.hpp"
+#include "slim/flac/Kernels.hpp"
 #include "slim/log/log.hpp"
+#include "slim/util/buffer/HeapBuffer.hpp"
+#include "slim/util/Duration.hpp"
+#include "slim/util/Timestamp.hpp"
 
 
 namespace slim
@@ -41,42 +47,27 @@ namespace slim
 				{
 					if (running)
 					{
-						std::size_t sampleSize{getBitsPerSample() >> 3};
-						std::size_t frameSize{sampleSize * getChannels()};
-						std::size_t frames{size / frameSize};
+						auto        startedAt{util::Timestamp::now()};
+						std::size_t samples{size / (getBitsPerSample() >> 3)};
+						std::size_t frames{samples / getChannels()};
 
-						// if values contain more than 24 bits then downscaling to 24 bits, which is max supported by FLAC
-						if (downScale)
+						// scratch buffer is reused by all chunks; it is reallocated only if a chunk is larger than any previous one
+						if (scratchBuffer.getSize() < samples)
 						{
-							for (std::size_t i = 0; i < size; i += sampleSize)
-							{
-								data[i] = 0;
-							}
+							scratchBuffer = ScratchBufferType{samples};
 						}
 
-						// coverting data S32_LE to S24_LE by shifting data by 1 byte
-						if (frames > 1 && !process_interleaved((const FLAC__int32*)(data + 1), frames - 1))
+						// converting S32_LE data to right-justified values; values with more than 24 bits lose their least significant bits
+						kernels::packSamples(data, scratchBuffer.getData(), frames * getChannels(), shift);
+
+						if (frames > 0 && !process_interleaved(scratchBuffer.getData(), frames))
 						{
 							LOG(ERROR) << LABELS{"flac"} << "Error while encoding: " << get_state().as_cstring();
 						}
 
-						// handling the last frame separately; shifting the last frame data by one byte
-						if (frames > 0)
-						{
-							unsigned char  frame[frameSize];
-							unsigned char* lastFrame{data + size - frameSize};
-
-							for (auto i{frameSize - 1}; i > 0; i--)
-							{
-								frame[i - 1] = lastFrame[i];
-							}
-							frame[frameSize - 1] = 0;
-
-							if (!process_interleaved((const FLAC__int32*)frame, 1))
-							{
-								LOG(ERROR) << LABELS{"flac"} << "Error while encoding: " << get_state().as_cstring();
-							}
-						}
+						// encoding time is measured against real-time duration of the stream to adapt compression level
+						encodingTime  += util::Timestamp::now() - startedAt;
+						encodedFrames += frames;
 					}
 				}
 
@@ -85,6 +76,18 @@ namespace slim
 					return running;
 				}
 
+				// compression level is provided by the controller, which is shared by all encoders created for subsequent streams
+				inline void setCompressionController(std::shared_ptr<CompressionController> c)
+				{
+					controllerPtr = std::move(c);
+				}
+
+				// libFLAC encodes blocks of a single stream concurrently since API version 14; ignored otherwise
+				inline void setThreads(unsigned int t)
+				{
+					threads = t;
+				}
+
 				virtual void start() override
 				{
 					// initializing encoder only if it is not initialized
@@ -96,11 +99,13 @@ namespace slim
 							throw Exception("Could not disable FLAC stream verification");
 						}
 
-						// setting minimal compression level (using max level does not gain much)
-						if (!set_compression_level(0))
+						// setting minimal compression level unless it is adapted to the available CPU budget
+						auto level{controllerPtr ? controllerPtr->getLevel() : 0u};
+						if (!set_compression_level(level))
 						{
 							throw Exception("Could not set compression level");
 						}
+						LOG(INFO) << LABELS{"flac"} << "FLAC compression level was set (level=" << level << ")";
 
 						// making sure encoded output is suitable for streaming
 						if (!set_streamable_subset(true))
@@ -132,9 +137,9 @@ namespace slim
 						{
 							LOG(WARNING) << LABELS{"flac"} << "PCM data will be scaled to 24 bits values, which is max bit depth supported by FLAC";
 
-							b         = 24;
-							downScale = true;
+							b = 24;
 						}
+						shift = 32 - b;
 
 						// setting sampling rate
 						if (!set_bits_per_sample(b))
@@ -142,6 +147,14 @@ namespace slim
 							throw Exception("Could not set bits per sample");
 						}
 
+#if defined(FLAC_API_VERSION_CURRENT) && FLAC_API_VERSION_CURRENT >= 14
+						// using libFLAC internal threads if requested; encoding falls back to a single thread if it is not supported
+						if (threads > 1 && set_num_threads(threads) != FLAC__STREAM_ENCODER_SET_NUM_THREADS_OK)
+						{
+							LOG(WARNING) << LABELS{"flac"} << "Could not set amount of encoding threads (threads=" << threads << ")";
+						}
+#endif
+
 						// initializing FLAC encoder
 						if (auto init_status{init()}; init_status != FLAC__STREAM_ENCODER_INIT_STATUS_OK)
 						{
@@ -162,6 +175,11 @@ namespace slim
 						}
 
 						running = false;
+
+						if (controllerPtr && getSamplingRate() > 0)
+						{
+							controllerPtr->update(encodingTime, util::Duration{static_cast<util::Duration::rep>((encodedFrames * 1000000) / getSamplingRate())});
+						}
 					}
 
 					// notifying that object can be deleted
@@ -169,6 +187,9 @@ namespace slim
 				}
 
 			protected:
+				// scratch buffer is filled by vectorized kernels, so it is aligned to the vector register size
+				using ScratchBufferType = util::buffer::HeapBuffer<FLAC__int32, util::buffer::AlignedHeapBufferStorage>;
+
 				virtual ::FLAC__StreamEncoderWriteStatus write_callback(const FLAC__byte* data, std::size_t size, unsigned samples, unsigned current_frame) override
 				{
 					getEncodedCallback()((unsigned char*)data, size);
@@ -177,8 +198,13 @@ namespace slim
 				}
 
 			private:
-				bool running{false};
-				bool downScale{false};
+				bool                                   running{false};
+				unsigned int                           shift{8};
+				unsigned int                           threads{1};
+				ScratchBufferType                      scratchBuffer;
+				std::shared_ptr<CompressionController> controllerPtr;
+				util::Duration                         encodingTime{0};
+				std::size_t                            encodedFrames{0};
 		};
 	}
 }
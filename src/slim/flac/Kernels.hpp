@@ -0,0 +1,73 @@
+/*
+ * Copyright 2017, Andrej Kislovskij
+ *
+ * This is PUBLIC DOMAIN software so use at your own risk as it comes
+ * with no warranties. This code is yours to share, use and modify without
+ * any restrictions or obligations.
+ *
+ * For more information see conwrap/LICENSE or refer refer to http://unlicense.org
+ *
+ * Author: gimesketvirtadieni at gmail dot com (Andrej Kislovskij)
+ */
+
+#pragma once
+
+#include <cstddef>  // std::size_t
+#include <cstdint>  // std::u..._t types
+#include <cstring>  // std::memcpy
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+namespace slim
+{
+	namespace flac
+	{
+		namespace kernels
+		{
+			// converts S32_LE samples to right-justified values expected by libFLAC; bits shifted out are dropped
+			inline void packSamplesScalar(const unsigned char* srcBuffer, std::int32_t* dstBuffer, std::size_t samples, unsigned int shift)
+			{
+				for (std::size_t i = 0; i < samples; i++)
+				{
+					std::int32_t value;
+
+					// PCM data is not guaranteed to be aligned so it is loaded with memcpy
+					std::memcpy(&value, srcBuffer + i * sizeof(value), sizeof(value));
+					dstBuffer[i] = value >> shift;
+				}
+			}
+
+			// the same as packSamplesScalar; the sign is preserved as arithmetic shift is used
+			inline void packSamples(const unsigned char* srcBuffer, std::int32_t* dstBuffer, std::size_t samples, unsigned int shift)
+			{
+				auto i{std::size_t{0}};
+
+#if defined(__AVX2__)
+				auto count{_mm_cvtsi32_si128(static_cast<int>(shift))};
+
+				for (; i + 8 <= samples; i += 8)
+				{
+					auto y{_mm256_loadu_si256(reinterpret_cast<const __m256i*>(srcBuffer + i * sizeof(std::int32_t)))};
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(dstBuffer + i), _mm256_sra_epi32(y, count));
+				}
+#elif defined(__SSE2__)
+				auto count{_mm_cvtsi32_si128(static_cast<int>(shift))};
+
+				for (; i + 4 <= samples; i += 4)
+				{
+					auto x{_mm_loadu_si128(reinterpret_cast<const __m128i*>(srcBuffer + i * sizeof(std::int32_t)))};
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(dstBuffer + i), _mm_sra_epi32(x, count));
+				}
+#endif
+
+				// processing samples which do not fit into a vector
+				packSamplesScalar(srcBuffer + i * sizeof(std::int32_t), dstBuffer + i, samples - i, shift);
+			}
+		}
+	}
+}
@@ -13,21 +13,22 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
 #include <chrono>
 #include <conwrap2/ProcessorProxy.hpp>
 #include <conwrap2/Timer.hpp>
 #include <cstddef>  // std::size_t, std::uint8_t
+#include <cstring>  // std::memcpy
 #include <functional>
 #include <memory>
 #include <scope_guard.hpp>
 #include <string>
 #include <sstream>
 #include <type_safe/optional.hpp>
+#include <string_view>
 #include <type_safe/optional_ref.hpp>
-#include <unordered_map>
 #include <vector>
 
-#include "slim/Chunk.hpp"
 #include "slim/ContainerBase.hpp"
 #include "slim/Exception.hpp"
 #include "slim/log/log.hpp"
@@ -36,6 +37,7 @@
 #include "slim/proto/client/CommandRESP.hpp"
 #include "slim/proto/client/CommandSETD.hpp"
 #include "slim/proto/client/CommandSTAT.hpp"
+#include "slim/proto/EncodingStage.hpp"
 #include "slim/proto/server/CommandAUDE.hpp"
 #include "slim/proto/server/CommandAUDG.hpp"
 #include "slim/proto/server/CommandSETD.hpp"
@@ -58,9 +60,6 @@ namespace slim
 		class CommandSession
 		{
 			protected:
-				using CommandHandlersMap = std::unordered_map<std::string, std::function<std::size_t(util::Timestamp)>>;
-				using EventHandlersMap   = std::unordered_map<std::string, std::function<void(client::CommandSTAT&, util::Timestamp)>>;
-
 				enum Event
 				{
 					StartEvent,
@@ -91,74 +90,25 @@ namespace slim
 					util::Duration  clientDuration;
 				};
 
+				// state machine uses transition table provided by getTransitions()
+				friend util::StateMachine<CommandSession, Event, State>;
+
 			public:
-				CommandSession(conwrap2::ProcessorProxy<std::unique_ptr<ContainerBase>> pp, std::reference_wrapper<ConnectionType> co, std::reference_wrapper<StreamerType> st, std::string id, unsigned int po, FormatSelection fo, ts::optional<unsigned int> ga)
+				CommandSession(conwrap2::ProcessorProxy<std::unique_ptr<ContainerBase>> pp, std::reference_wrapper<ConnectionType> co, std::reference_wrapper<StreamerType> st, std::string id, unsigned int po, FormatSelection fo, unsigned int bs, ts::optional<unsigned int> ga)
 				: processorProxy{pp}
 				, connection{co}
 				, streamer{st}
 				, clientID{id}
 				, streamingPort{po}
 				, formatSelection{fo}
+				, bitsPerSample{bs}
 				, gain{ga}
-				, commandHandlers
-				{
-					{"DSCO", [&](auto timestamp) {return onDSCO();}},
-					{"HELO", [&](auto timestamp) {return onHELO();}},
-					{"RESP", [&](auto timestamp) {return onRESP();}},
-					{"SETD", [&](auto timestamp) {return onSETD();}},
-					{"STAT", [&](auto timestamp) {return onSTAT(timestamp);}},
-				}
-				, eventHandlers
-				{
-					{"STMc", [&](auto& commandSTAT, auto timestamp) {}},
-					{"STMd", [&](auto& commandSTAT, auto timestamp) {}},
-					{"STMf", [&](auto& commandSTAT, auto timestamp) {onSTMf(commandSTAT);}},
-					{"STMl", [&](auto& commandSTAT, auto timestamp) {onSTMl(commandSTAT);}},
-					{"STMo", [&](auto& commandSTAT, auto timestamp) {}},
-					{"STMp", [&](auto& commandSTAT, auto timestamp) {}},
-					{"STMr", [&](auto& commandSTAT, auto timestamp) {}},
-					{"STMs", [&](auto& commandSTAT, auto timestamp) {onSTMs(commandSTAT);}},
-					{"STMt", [&](auto& commandSTAT, auto timestamp) {onSTMt(commandSTAT, timestamp);}},
-					{"STMu", [&](auto& commandSTAT, auto timestamp) {onSTMu(commandSTAT);}},
-				}
-				, stateMachine
-				{
-					StoppedState,  // initial state
-					{   // transition table definition
-						{StartEvent,     StartedState,   StartedState,   [&](auto event) {},                          [&] {return true;}},
-						{StartEvent,     PreparingState, PreparingState, [&](auto event) {},                          [&] {return true;}},
-						{StartEvent,     BufferingState, BufferingState, [&](auto event) {},                          [&] {return true;}},
-						{StartEvent,     PlayingState,   PlayingState,   [&](auto event) {},                          [&] {return true;}},
-						{StartEvent,     DrainingState,  DrainingState,  [&](auto event) {},                          [&] {return true;}},
-						{StartEvent,     StoppedState,   StartedState,   [&](auto event) {},                          [&] {return true;}},
-						{HandshakeEvent, StartedState,   DrainingState,  [&](auto event) {},                          [&] {return true;}},
-						{PrepareEvent,   StartedState,   PreparingState, [&](auto event) {stateChangeToPreparing();}, [&] {return isReadyToPrepare();}},
-						{PrepareEvent,   PreparingState, PreparingState, [&](auto event) {},                          [&] {return true;}},
-						{PrepareEvent,   BufferingState, BufferingState, [&](auto event) {},                          [&] {return true;}},
-						{PrepareEvent,   PlayingState,   PlayingState,   [&](auto event) {},                          [&] {return true;}},
-						{BufferEvent,    PreparingState, BufferingState, [&](auto event) {},                          [&] {return isReadyToBuffer();}},
-						{BufferEvent,    BufferingState, BufferingState, [&](auto event) {},                          [&] {return true;}},
-						{BufferEvent,    PlayingState,   PlayingState,   [&](auto event) {},                          [&] {return true;}},
-						{PlayEvent,      BufferingState, PlayingState,   [&](auto event) {stateChangeToPlaying();},   [&] {return isReadyToPlay();}},
-						{PlayEvent,      PlayingState,   PlayingState,   [&](auto event) {},                          [&] {return true;}},
-						{DrainEvent,     PreparingState, DrainingState,  [&](auto event) {},                          [&] {return true;}},
-						{DrainEvent,     BufferingState, DrainingState,  [&](auto event) {},                          [&] {return true;}},
-						{DrainEvent,     PlayingState,   DrainingState,  [&](auto event) {},                          [&] {return true;}},
-						{DrainEvent,     DrainingState,  DrainingState,  [&](auto event) {},                          [&] {return true;}},
-						{DrainEvent,     StartedState,   StartedState,   [&](auto event) {},                          [&] {return true;}},
-						{FlushedEvent,   StartedState,   StartedState,   [&](auto event) {},                          [&] {return true;}},
-						{FlushedEvent,   PreparingState, PreparingState, [&](auto event) {},                          [&] {return true;}},
-						{FlushedEvent,   PlayingState,   PlayingState,   [&](auto event) {},                          [&] {return true;}},
-						{FlushedEvent,   DrainingState,  StartedState,   [&](auto event) {},                          [&] {return true;}},
-						{StopEvent,      StoppedState,   StoppedState,   [&](auto event) {},                          [&] {return true;}},
-						{StopEvent,      StartedState,   StoppedState,   [&](auto event) {stateChangeToStopped();},   [&] {return true;}},
-						{StopEvent,      PreparingState, StoppedState,   [&](auto event) {stateChangeToStopped();},   [&] {return true;}},
-						{StopEvent,      BufferingState, StoppedState,   [&](auto event) {stateChangeToStopped();},   [&] {return true;}},
-						{StopEvent,      PlayingState,   StoppedState,   [&](auto event) {stateChangeToStopped();},   [&] {return true;}},
-						{StopEvent,      DrainingState,  StoppedState,   [&](auto event) {stateChangeToStopped();},   [&] {return true;}},
-					}
-				}
+				, stateMachine{*this, StoppedState}
 				{
+					// TODO: parameterize
+					outboundBuffer.reserve(256);
+					sendingBufferPtr->reserve(256);
+
 					LOG(DEBUG) << LABELS{"proto"} << "SlimProto session object was created (id=" << this << ")";
 				}
 
@@ -170,6 +120,12 @@ namespace slim
 						timer.cancel();
 					});
 
+					// commands queued behind an in-flight write are not sent as session is gone
+					if (!outboundBuffer.empty())
+					{
+						LOG(DEBUG) << LABELS{"proto"} << "Outbound SlimProto commands were dropped (id=" << this << ", size=" << outboundBuffer.size() << ")";
+					}
+
 					LOG(DEBUG) << LABELS{"proto"} << "SlimProto session object was deleted (id=" << this << ")";
 				}
 
@@ -178,7 +134,7 @@ namespace slim
 				CommandSession(CommandSession&& rhs) = delete;              // non-movable
 				CommandSession& operator=(CommandSession&& rhs) = delete;   // non-movable-assignable
 
-				inline bool consumeChunk(const Chunk& chunk)
+				inline bool consumeChunk(const EncodedChunk& chunk)
 				{
 					auto result = true;
 
@@ -250,6 +206,41 @@ namespace slim
 					return stateMachine.state == DrainingState;
 				}
 
+				static constexpr bool isSupportedCommand(std::uint32_t opcode)
+				{
+					switch (opcode)
+					{
+						case toOpcode(client::DSCO::LABEL):
+						case toOpcode(client::HELO::LABEL):
+						case toOpcode(client::RESP::LABEL):
+						case toOpcode(client::SETD::LABEL):
+						case toOpcode(client::STAT::LABEL):
+							return true;
+						default:
+							return false;
+					}
+				}
+
+				static constexpr bool isSupportedEvent(std::uint32_t event)
+				{
+					switch (event)
+					{
+						case toOpcode("STMc"):
+						case toOpcode("STMd"):
+						case toOpcode("STMf"):
+						case toOpcode("STMl"):
+						case toOpcode("STMo"):
+						case toOpcode("STMp"):
+						case toOpcode("STMr"):
+						case toOpcode("STMs"):
+						case toOpcode("STMt"):
+						case toOpcode("STMu"):
+							return true;
+						default:
+							return false;
+					}
+				}
+
 				inline auto isReadyToBuffer()
 				{
 					return isReadyToPrepare() && streamingSession.has_value();
@@ -278,11 +269,16 @@ namespace slim
 						commandRingBuffer.clear();
 					};
 
-					// adding data to the buffer
-					for (std::size_t i{0}; i < size; i++)
+					// commands issued while processing a request (like the handshake burst) are coalesced and sent with one write
+					corked = true;
+					::util::scope_guard onExit = [&]
 					{
-						commandRingBuffer.push(buffer[i]);
-					}
+						corked = false;
+						flush();
+					};
+
+					// adding data to the buffer
+					commandRingBuffer.push(buffer, size);
 /*
 					std::stringstream ss;
 					ss << "Command buffer content:" << std::endl;
@@ -290,54 +286,39 @@ namespace slim
 					LOG(INFO) << LABELS{"proto"} << ss.str();
 */
 					// keep processing until there is anything to process in the buffer
-					std::size_t keySize{4};
+					constexpr std::size_t keySize{4};
 					std::size_t processedSize;
 					do
 					{
 						processedSize = 0;
-						auto label{ts::optional<std::string>{ts::nullopt}};
 
 						if (keySize <= commandRingBuffer.getSize())
 						{
-							char labelCharacters[keySize] = {(char)commandRingBuffer[0], (char)commandRingBuffer[1], (char)commandRingBuffer[2], (char)commandRingBuffer[3]};
-							label = std::string{labelCharacters, keySize};
-						}
-
-						auto found{commandHandlers.end()};
-						ts::with(label, [&](auto& label)
-						{
-							// searching for a command handler based on provided label
-							found = commandHandlers.find(label);
+							char label[keySize];
+							commandRingBuffer.copy(0, reinterpret_cast<std::uint8_t*>(label), keySize);
+							auto opcode{toOpcode(label)};
 
 							// label is present in the buffer but no command handler was found
-							if (found == commandHandlers.end())
+							if (!isSupportedCommand(opcode))
 							{
-								LOG(WARNING) << LABELS{"proto"} << "Unsupported SlimProto command received, skipping one character (header='" << label << "')";
+								LOG(WARNING) << LABELS{"proto"} << "Unsupported SlimProto command received, skipping one character (header='" << std::string_view{label, keySize} << "')";
 
 								commandRingBuffer.pop();
 							}
-						});
-
-						if (found != commandHandlers.end())
-						{
 							// if there is enough data to process this message
-							if (InboundCommand<char>::isEnoughData(commandRingBuffer))
+							else if (InboundCommand<char>::isEnoughData(commandRingBuffer))
 							{
 								// if this is not STAT command then reseting measuring flag
-								// TODO: consider proper usage of Command label
-								if (label.value().compare("STAT") != 0)
+								if (opcode != toOpcode(client::STAT::LABEL))
 								{
 									measuringLatency = false;
 								}
 
 								// processing data
-								processedSize = (*found).second(timestamp);
+								processedSize = dispatchCommand(opcode, timestamp);
 
 								// removing processed data from the buffer
-								for (auto i{std::size_t{0}}; i < processedSize; i++)
-								{
-									commandRingBuffer.pop();
-								}
+								commandRingBuffer.pop(processedSize);
 							}
 						}
 					} while (processedSize > 0);
@@ -392,10 +373,38 @@ namespace slim
 						});
 					}
 
-					callback();
+					// callback is invoked once queued commands (including Stop command) are handed over to the network stack
+					stopCallbacks.emplace_back(std::move(callback));
+					completeStop();
 				}
 
 			protected:
+				inline std::size_t dispatchCommand(std::uint32_t opcode, util::Timestamp timestamp)
+				{
+					switch (opcode)
+					{
+						case toOpcode(client::DSCO::LABEL): return onDSCO();
+						case toOpcode(client::HELO::LABEL): return onHELO();
+						case toOpcode(client::RESP::LABEL): return onRESP();
+						case toOpcode(client::SETD::LABEL): return onSETD();
+						case toOpcode(client::STAT::LABEL): return onSTAT(timestamp);
+						default:                            return 0;
+					}
+				}
+
+				inline void dispatchEvent(std::uint32_t event, client::CommandSTAT& commandSTAT, util::Timestamp timestamp)
+				{
+					switch (event)
+					{
+						case toOpcode("STMf"): onSTMf(commandSTAT);            break;
+						case toOpcode("STMl"): onSTMl(commandSTAT);            break;
+						case toOpcode("STMs"): onSTMs(commandSTAT);            break;
+						case toOpcode("STMt"): onSTMt(commandSTAT, timestamp); break;
+						case toOpcode("STMu"): onSTMu(commandSTAT);            break;
+						default:                                               break;
+					}
+				}
+
 				inline auto getAccurateDurationIndex() const
 				{
 					auto result{ts::optional<std::size_t>{ts::nullopt}};
@@ -446,6 +455,45 @@ namespace slim
 					return result;
 				}
 
+				static constexpr auto getTransitions()
+				{
+					// transition table definition; it is converted into a lookup matrix at compile time
+					return std::array<util::Transition<CommandSession, Event, State>, 31>
+					{{
+						{StartEvent,     StartedState,   StartedState,   nullptr,                                 nullptr},
+						{StartEvent,     PreparingState, PreparingState, nullptr,                                 nullptr},
+						{StartEvent,     BufferingState, BufferingState, nullptr,                                 nullptr},
+						{StartEvent,     PlayingState,   PlayingState,   nullptr,                                 nullptr},
+						{StartEvent,     DrainingState,  DrainingState,  nullptr,                                 nullptr},
+						{StartEvent,     StoppedState,   StartedState,   nullptr,                                 nullptr},
+						{HandshakeEvent, StartedState,   DrainingState,  nullptr,                                 nullptr},
+						{PrepareEvent,   StartedState,   PreparingState, &CommandSession::stateChangeToPreparing, &CommandSession::isReadyToPrepare},
+						{PrepareEvent,   PreparingState, PreparingState, nullptr,                                 nullptr},
+						{PrepareEvent,   BufferingState, BufferingState, nullptr,                                 nullptr},
+						{PrepareEvent,   PlayingState,   PlayingState,   nullptr,                                 nullptr},
+						{BufferEvent,    PreparingState, BufferingState, nullptr,                                 &CommandSession::isReadyToBuffer},
+						{BufferEvent,    BufferingState, BufferingState, nullptr,                                 nullptr},
+						{BufferEvent,    PlayingState,   PlayingState,   nullptr,                                 nullptr},
+						{PlayEvent,      BufferingState, PlayingState,   &CommandSession::stateChangeToPlaying,   &CommandSession::isReadyToPlay},
+						{PlayEvent,      PlayingState,   PlayingState,   nullptr,                                 nullptr},
+						{DrainEvent,     PreparingState, DrainingState,  nullptr,                                 nullptr},
+						{DrainEvent,     BufferingState, DrainingState,  nullptr,                                 nullptr},
+						{DrainEvent,     PlayingState,   DrainingState,  nullptr,                                 nullptr},
+						{DrainEvent,     DrainingState,  DrainingState,  nullptr,                                 nullptr},
+						{DrainEvent,     StartedState,   StartedState,   nullptr,                                 nullptr},
+						{FlushedEvent,   StartedState,   StartedState,   nullptr,                                 nullptr},
+						{FlushedEvent,   PreparingState, PreparingState, nullptr,                                 nullptr},
+						{FlushedEvent,   PlayingState,   PlayingState,   nullptr,                                 nullptr},
+						{FlushedEvent,   DrainingState,  StartedState,   nullptr,                                 nullptr},
+						{StopEvent,      StoppedState,   StoppedState,   nullptr,                                 nullptr},
+						{StopEvent,      StartedState,   StoppedState,   &CommandSession::stateChangeToStopped,   nullptr},
+						{StopEvent,      PreparingState, StoppedState,   &CommandSession::stateChangeToStopped,   nullptr},
+						{StopEvent,      BufferingState, StoppedState,   &CommandSession::stateChangeToStopped,   nullptr},
+						{StopEvent,      PlayingState,   StoppedState,   &CommandSession::stateChangeToStopped,   nullptr},
+						{StopEvent,      DrainingState,  StoppedState,   &CommandSession::stateChangeToStopped,   nullptr},
+					}};
+				}
+
 				inline auto onDSCO()
 				{
 					std::size_t result{0};
@@ -536,25 +584,23 @@ namespace slim
 					auto commandSTAT{client::CommandSTAT{commandRingBuffer}};
 					auto result{commandSTAT.getSize()};
 
-					auto event{std::string{commandSTAT.getData()->event, 4}};
-					auto found{eventHandlers.find(event)};
+					auto event{toOpcode(commandSTAT.getData()->event)};
 
-					if (found != eventHandlers.end())
+					if (isSupportedEvent(event))
 					{
 						// if this is not STMt event then reseting measuring flag
-						// TODO: consider proper usage of STAT event label
-						if (event.compare("STMt") != 0)
+						if (event != toOpcode("STMt"))
 						{
-							LOG(DEBUG) << LABELS{"proto"} << event << " event received";
+							LOG(DEBUG) << LABELS{"proto"} << std::string_view{commandSTAT.getData()->event, 4} << " event received";
 							measuringLatency = false;
 						}
 
 						// invoking STAT event handler
-						(*found).second(commandSTAT, receiveTimestamp);
+						dispatchEvent(event, commandSTAT, receiveTimestamp);
 					}
 					else
 					{
-						LOG(DEBUG) << LABELS{"proto"} << "Unsupported STAT event received: " << event;
+						LOG(DEBUG) << LABELS{"proto"} << "Unsupported STAT event received: " << std::string_view{commandSTAT.getData()->event, 4};
 					}
 
 					return result;
@@ -712,23 +758,88 @@ namespace slim
 					}
 				}
 
+				inline void completeStop()
+				{
+					// waiting for the outbox to drain unless commands can not be sent anymore
+					if (stopCallbacks.empty() || ((sending || !outboundBuffer.empty()) && connection.get().isOpen()))
+					{
+						return;
+					}
+
+					// callbacks may delete this session, so they are moved out before they are invoked
+					auto callbacks{std::move(stopCallbacks)};
+					stopCallbacks.clear();
+					for (auto& callback : callbacks)
+					{
+						callback();
+					}
+				}
+
+				inline void flush()
+				{
+					if (corked || sending || outboundBuffer.empty())
+					{
+						return;
+					}
+
+					// swapping buffers keeps their capacity, so no allocation happens once both buffers are warmed up
+					std::swap(*sendingBufferPtr, outboundBuffer);
+					std::swap(sendingProbes, outboundProbes);
+					outboundBuffer.clear();
+					outboundProbes.clear();
+					sending = true;
+
+					// in-flight buffer is owned by the write handler as the session may be deleted before the write is completed
+					connection.get().writeAsync(sendingBufferPtr->data(), sendingBufferPtr->size(), [this, bufferPtr = sendingBufferPtr, alive = std::weak_ptr<bool>{alivePtr}](auto error, auto, auto timestamp)
+					{
+						// ping timestamp is captured by the socket thread when data was actually handed over to the network stack
+						if (!alive.lock())
+						{
+							return;
+						}
+						sending = false;
+
+						if (error)
+						{
+							LOG(ERROR) << LABELS{"proto"} << "Error while sending SlimProto commands (id=" << this << ", error=" << error.message() << ")";
+
+							// the rest of commands will not make it either
+							outboundBuffer.clear();
+							outboundProbes.clear();
+						}
+						else
+						{
+							for (auto index : sendingProbes)
+							{
+								if (index < probes.size())
+								{
+									probes[index].sendTimestamp = timestamp;
+								}
+							}
+						}
+						sendingProbes.clear();
+
+						// sending commands which were queued while this write was in flight
+						flush();
+
+						// must be the last statement as stop callback may delete this session
+						completeStop();
+					});
+				}
+
 				inline void ping(std::uint32_t index)
 				{
 					// creating a ping command
 					auto command{server::CommandSTRM{CommandSelection::Time}};
 					command.getBuffer()->data.replayGain = index + 1;
 
-					// capturing server timestamp as close as possible to the send operation
-					auto timestamp{util::Timestamp::now()};
-
-					// sending actual ping command
+					// probe index must be queued before the command, so it is sent with the same write that carries this ping
+					// and its timestamp is stored once that write is completed
+					outboundProbes.push_back(index);
 					send(command);
 
 					// changing state to 'measuringLatency' which is used to track if there any interference while measuring latency
 					measuringLatency = true;
-
-					// storing actually sent timestamp in the cache
-					probes[index].sendTimestamp = timestamp;
 				}
 
 				template<typename CommandType>
@@ -736,8 +847,12 @@ namespace slim
 				{
 					measuringLatency = false;
 
-					// TODO: use local buffer and async API to prevent from interfering while measuring latency
-					connection.get().write(command.getBuffer(), command.getSize());
+					// serializing command into the outbound buffer; it is sent right away unless a write is in flight or session is corked
+					auto offset{outboundBuffer.size()};
+					outboundBuffer.resize(offset + command.getSize());
+					std::memcpy(outboundBuffer.data() + offset, command.getBuffer(), command.getSize());
+
+					flush();
 				}
 
 				inline void stateChangeToPlaying()
@@ -757,7 +872,7 @@ namespace slim
 					// resetting drift base value as it should be calculated for every new playback
 					playbackDriftBase.reset();
 
-					send(server::CommandSTRM{CommandSelection::Start, formatSelection, streamingPort, samplingRate, clientID});
+					send(server::CommandSTRM{CommandSelection::Start, formatSelection, bitsPerSample, streamingPort, samplingRate, clientID});
 				}
 
 				inline void stateChangeToStopped()
@@ -773,10 +888,9 @@ namespace slim
 				std::string                                                      clientID;
 				unsigned int                                                     streamingPort;
 				FormatSelection                                                  formatSelection;
+				unsigned int                                                     bitsPerSample;
 				ts::optional<unsigned int>                                       gain;
-				CommandHandlersMap                                               commandHandlers;
-				EventHandlersMap                                                 eventHandlers;
-				util::StateMachine<Event, State>                                 stateMachine;
+				util::StateMachine<CommandSession, Event, State>                 stateMachine;
 				unsigned int                                                     samplingRate{0};
 				ts::optional_ref<StreamingSession<ConnectionType, StreamerType>> streamingSession{ts::nullopt};
 				// TODO: parameterize
@@ -792,6 +906,14 @@ namespace slim
 				bool                                                             clientBufferIsReady{false};
 				util::Timestamp                                                  lastChunkTimestamp;
 				util::BigInteger                                                 lastChunkCapturedFrames{0};
+				std::vector<std::uint8_t>                                        outboundBuffer;
+				std::shared_ptr<std::vector<std::uint8_t>>                       sendingBufferPtr{std::make_shared<std::vector<std::uint8_t>>()};
+				std::vector<std::uint32_t>                                       outboundProbes;
+				std::vector<std::uint32_t>                                       sendingProbes;
+				bool                                                             sending{false};
+				bool                                                             corked{false};
+				std::vector<std::function<void()>>                               stopCallbacks;
+				std::shared_ptr<bool>                                            alivePtr{std::make_shared<bool>(true)};
 		};
 	}
 }
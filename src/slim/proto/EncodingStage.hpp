@@ -0,0 +1,427 @@
+/*
+ * Copyright 2017, Andrej Kislovskij
+ *
+ * This is PUBLIC DOMAIN software so use at your own risk as it comes
+ * with no warranties. This code is yours to share, use and modify without
+ * any restrictions or obligations.
+ *
+ * For more information see conwrap/LICENSE or refer refer to http://unlicense.org
+ *
+ * Author: gimesketvirtadieni at gmail dot com (Andrej Kislovskij)
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>  // std::size_t
+#include <cstdint>  // std::u..._t types
+#include <cstring>  // std::memcpy
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>  // std::move
+#include <vector>
+
+#include "slim/Chunk.hpp"
+#include "slim/EncoderBase.hpp"
+#include "slim/EncoderBuilder.hpp"
+#include "slim/log/log.hpp"
+#include "slim/util/BigInteger.hpp"
+#include "slim/util/buffer/HeapBuffer.hpp"
+#include "slim/util/RealTimeQueue.hpp"
+#include "slim/util/Timestamp.hpp"
+
+
+namespace slim
+{
+	namespace proto
+	{
+		// encoded segments are shared by all streaming sessions, so they are never modified once created
+		using EncodedSegment    = util::buffer::HeapBuffer<std::uint8_t>;
+		using EncodedSegmentPtr = std::shared_ptr<const EncodedSegment>;
+		using EncodedSegments   = std::vector<EncodedSegmentPtr>;
+
+		struct EncodedChunk
+		{
+			bool             endOfStream{false};
+			unsigned int     samplingRate{0};
+			std::size_t      frames{0};
+			util::BigInteger capturedFrames{0};
+			util::Timestamp  timestamp;
+			EncodedSegments  segments;
+		};
+
+		// encoded chunks are kept in the streamer's history, which is shared by all sessions
+		using EncodedChunkPtr = std::shared_ptr<const EncodedChunk>;
+
+		class EncodingStage
+		{
+			// PCM data is copied into a job, so the source chunk can be released as soon as the job is submitted
+			struct EncodingJob
+			{
+				EncodedChunk              metadata;
+				std::vector<std::uint8_t> data;
+				unsigned int              generation{0};
+			};
+
+			struct EncodingResult
+			{
+				EncodedChunkPtr encodedChunkPtr;
+				unsigned int    generation{0};
+			};
+
+			// an encoder which was initialized ahead of time along with the stream header it produced
+			struct StandbyEncoder
+			{
+				std::unique_ptr<EncoderBase> encoderPtr;
+				EncodedSegments              header;
+			};
+
+			public:
+				using ReadyCallbackType = std::function<void()>;
+
+				// if asynchronous, chunks are encoded by a dedicated worker thread; otherwise encoding is done by the caller
+				EncodingStage(EncoderBuilder eb, bool as = false)
+				: encoderBuilder{eb}
+				, asynchronous{as}
+				, jobs{queueSize}
+				, results{queueSize}
+				{
+					encoderBuilder.setEncodedCallback([&](auto* encodedData, auto encodedDataSize)
+					{
+						// encoded data is copied once and then it is referenced by all streaming sessions
+						auto segmentPtr{std::make_shared<EncodedSegment>(encodedDataSize)};
+						std::memcpy(segmentPtr->getData(), encodedData, encodedDataSize);
+
+						pendingSegments.push_back(std::move(segmentPtr));
+					});
+
+					if (asynchronous)
+					{
+						workerThread = std::thread{[&]
+						{
+							LOG(DEBUG) << LABELS{"proto"} << "Encoding thread was started (id=" << std::this_thread::get_id() << ")";
+
+							work();
+
+							LOG(DEBUG) << LABELS{"proto"} << "Encoding thread was stopped (id=" << std::this_thread::get_id() << ")";
+						}};
+					}
+				}
+
+				~EncodingStage()
+				{
+					if (workerThread.joinable())
+					{
+						{
+							std::lock_guard<std::mutex> lock{workerLock};
+							workerRunning = false;
+						}
+						workerCondition.notify_one();
+						workerThread.join();
+					}
+
+					stop();
+
+					dropStandbyEncoders(0);
+					pendingSegments.clear();
+				}
+
+				EncodingStage(const EncodingStage&) = delete;             // non-copyable
+				EncodingStage& operator=(const EncodingStage&) = delete;  // non-assignable
+				EncodingStage(EncodingStage&& rhs) = delete;              // non-movable
+				EncodingStage& operator=(EncodingStage&& rhs) = delete;   // non-move-assignable
+
+				// consumer is called for every chunk encoded by the worker thread, in the order chunks were submitted
+				template <typename ConsumerType>
+				inline void collect(ConsumerType consumer)
+				{
+					auto collected{results.dequeueBatch(results.getCapacity(), [&](EncodingResult* items, std::size_t count)
+					{
+						for (std::size_t i{0}; i < count; i++)
+						{
+							// results produced before the stage was restarted belong to a stream, which is gone
+							if (items[i].generation == generation.load(std::memory_order_relaxed))
+							{
+								consumer(items[i].encodedChunkPtr);
+							}
+							items[i].encodedChunkPtr.reset();
+						}
+						return count;
+					}, [] {})};
+
+					inFlight -= collected;
+				}
+
+				inline EncodedChunk encode(Chunk& chunk)
+				{
+					return encode(EncodedChunk{chunk.endOfStream, chunk.samplingRate, chunk.frames, chunk.capturedFrames, chunk.timestamp, {}}, chunk.buffer.getData(), chunk.frames * chunk.bytesPerSample * chunk.channels);
+				}
+
+				inline const auto& getHeader() const
+				{
+					return header;
+				}
+
+				inline auto getMIME()
+				{
+					return encoderBuilder.getMIME();
+				}
+
+				inline auto getSamplingRate() const
+				{
+					return samplingRate;
+				}
+
+				// chunks submitted to the worker thread which were not collected yet
+				inline bool hasPendingChunks() const
+				{
+					return inFlight > 0;
+				}
+
+				inline bool isAsynchronous() const
+				{
+					return asynchronous;
+				}
+
+				inline bool isRunning()
+				{
+					std::lock_guard<std::mutex> lock{encoderLock};
+
+					return encoderPtr && encoderPtr->isRunning();
+				}
+
+				// initializes an encoder for the provided sampling rate, so the next stream with this rate does not pay for encoder initialization
+				inline void prewarm(unsigned int s)
+				{
+					std::lock_guard<std::mutex> lock{encoderLock};
+
+					// pool is bounded to a single encoder for the expected sampling rate
+					dropStandbyEncoders(s);
+
+					if (s && standbyEncoders.find(s) == standbyEncoders.end())
+					{
+						standbyEncoders.emplace(s, createEncoder(s));
+
+						LOG(DEBUG) << LABELS{"proto"} << "Standby encoder was created (rate=" << s << ")";
+					}
+				}
+
+				// callback is invoked by the worker thread, so it should only post a notification to the processor thread
+				inline void setReadyCallback(ReadyCallbackType rc)
+				{
+					readyCallback = std::move(rc);
+				}
+
+				inline void start(unsigned int s)
+				{
+					// previous stream is finished before starting a new one
+					stop();
+
+					std::lock_guard<std::mutex> lock{encoderLock};
+
+					// a finished encoder can not be restarted, so a standby encoder is checked out and it is not returned to the pool
+					auto standbyEncoder{StandbyEncoder{}};
+					auto prewarmed{false};
+					if (auto found{standbyEncoders.find(s)}; found != standbyEncoders.end())
+					{
+						standbyEncoder = std::move(found->second);
+						standbyEncoders.erase(found);
+						prewarmed      = true;
+					}
+					else
+					{
+						standbyEncoder = createEncoder(s);
+					}
+
+					// standby encoder which was not used for this stream is not kept around
+					dropStandbyEncoders(s);
+
+					samplingRate = s;
+					encoderPtr   = std::move(standbyEncoder.encoderPtr);
+					header       = std::move(standbyEncoder.header);
+
+					LOG(DEBUG) << LABELS{"proto"} << "Encoding stage was started (rate=" << samplingRate << ", header size=" << header.size() << " segment(s), prewarmed=" << prewarmed << ")";
+				}
+
+				inline void stop()
+				{
+					std::lock_guard<std::mutex> lock{encoderLock};
+
+					// jobs and results which are still queued are discarded once the generation is changed
+					generation++;
+
+					if (encoderPtr)
+					{
+						encoderPtr->stop([] {});
+						encoderPtr.reset();
+					}
+
+					// there are no consumers for the data produced while stopping
+					pendingSegments.clear();
+					header.clear();
+					samplingRate = 0;
+				}
+
+				// returns false if the worker thread has too many outstanding jobs, in which case the chunk should be submitted later
+				inline bool submit(Chunk& chunk)
+				{
+					if (inFlight >= jobs.getCapacity())
+					{
+						return false;
+					}
+
+					jobs.enqueue([&](EncodingJob& job)
+					{
+						auto size{chunk.frames * chunk.bytesPerSample * chunk.channels};
+
+						// job buffers are reused, so allocation happens only when a chunk is larger than any previous one
+						job.metadata   = EncodedChunk{chunk.endOfStream, chunk.samplingRate, chunk.frames, chunk.capturedFrames, chunk.timestamp, {}};
+						job.generation = generation.load(std::memory_order_relaxed);
+						job.data.resize(size);
+						std::memcpy(job.data.data(), chunk.buffer.getData(), size);
+
+						return true;
+					}, [] {});
+					inFlight++;
+
+					// taking the lock guarantees the worker is either waiting or will see the new job before it goes to sleep
+					{
+						std::lock_guard<std::mutex> lock{workerLock};
+					}
+					workerCondition.notify_one();
+
+					return true;
+				}
+
+			protected:
+				inline void dropStandbyEncoders(unsigned int keptSamplingRate)
+				{
+					for (auto entry{standbyEncoders.begin()}; entry != standbyEncoders.end();)
+					{
+						if (entry->first == keptSamplingRate)
+						{
+							entry++;
+							continue;
+						}
+
+						// standby encoders are stopped explicitly as stopping may produce data, which is delivered to this object
+						entry->second.encoderPtr->stop([] {});
+						pendingSegments.clear();
+
+						LOG(DEBUG) << LABELS{"proto"} << "Standby encoder was dropped (rate=" << entry->first << ")";
+
+						entry = standbyEncoders.erase(entry);
+					}
+				}
+
+				inline StandbyEncoder createEncoder(unsigned int s)
+				{
+					auto standbyEncoder{StandbyEncoder{}};
+
+					// an encoder is created per stream as encoding parameters may differ between streams
+					encoderBuilder.setSamplingRate(s);
+					standbyEncoder.encoderPtr = std::move(encoderBuilder.build());
+					standbyEncoder.encoderPtr->start();
+
+					// anything produced by the encoder while starting is a stream header, which is required by every new client
+					standbyEncoder.header = std::move(pendingSegments);
+					pendingSegments.clear();
+
+					return standbyEncoder;
+				}
+
+				inline EncodedChunk encode(EncodedChunk&& encodedChunk, std::uint8_t* data, std::size_t size)
+				{
+					if (encoderPtr && encoderPtr->isRunning())
+					{
+						encoderPtr->encode(data, size);
+
+						// stopping encoder flushes its internal buffer, so the tail of the stream is delivered with the last chunk
+						if (encodedChunk.endOfStream)
+						{
+							encoderPtr->stop([] {});
+						}
+					}
+
+					encodedChunk.segments = std::move(pendingSegments);
+					pendingSegments.clear();
+
+					return std::move(encodedChunk);
+				}
+
+				inline void work()
+				{
+					for (;;)
+					{
+						{
+							std::unique_lock<std::mutex> lock{workerLock};
+							workerCondition.wait(lock, [&]
+							{
+								return !workerRunning || jobs.getReadySize() > 0;
+							});
+
+							if (!workerRunning)
+							{
+								break;
+							}
+						}
+
+						// results queue never overflows as the amount of submitted jobs is bounded by its capacity
+						jobs.dequeue([&](EncodingJob& job)
+						{
+							EncodedChunkPtr encodedChunkPtr;
+							{
+								// encoder is (re)created by the processor thread, so it is accessed under the lock
+								std::lock_guard<std::mutex> lock{encoderLock};
+
+								if (job.generation == generation.load(std::memory_order_relaxed))
+								{
+									encodedChunkPtr = std::make_shared<const EncodedChunk>(encode(std::move(job.metadata), job.data.data(), job.data.size()));
+								}
+							}
+
+							results.enqueue([&](EncodingResult& result)
+							{
+								result.encodedChunkPtr = std::move(encodedChunkPtr);
+								result.generation      = job.generation;
+
+								return true;
+							}, [] {});
+
+							return true;
+						}, [] {});
+
+						if (readyCallback)
+						{
+							readyCallback();
+						}
+					}
+				}
+
+			private:
+				static constexpr std::size_t queueSize{16};  // must be a power of 2
+
+				EncoderBuilder                                   encoderBuilder;
+				bool                                             asynchronous;
+				std::unique_ptr<EncoderBase>                     encoderPtr;
+				unsigned int                                     samplingRate{0};
+				EncodedSegments                                  header;
+				EncodedSegments                                  pendingSegments;
+				std::unordered_map<unsigned int, StandbyEncoder> standbyEncoders;
+				std::mutex                                       encoderLock;
+				std::atomic<unsigned int>                        generation{0};
+				util::RealTimeQueue<EncodingJob>                 jobs;
+				util::RealTimeQueue<EncodingResult>              results;
+				std::size_t                                      inFlight{0};
+				ReadyCallbackType                                readyCallback;
+				std::thread                                      workerThread;
+				std::mutex                                       workerLock;
+				std::condition_variable                          workerCondition;
+				bool                                             workerRunning{true};
+		};
+	}
+}
@@ -14,8 +14,9 @@
 
 #include <cstddef>  // std::size_t
 #include <cstdint>  // std::u..._t types
+#include <string_view>
 
-#include "slim/util/buffer/HeapBuffer.hpp"
+#include "slim/Exception.hpp"
 #include "slim/util/buffer/Ring.hpp"
 
 
@@ -23,6 +24,15 @@ namespace slim
 {
 	namespace proto
 	{
+		// opcodes and STAT events are 4-character labels, so they are handled as 32-bit integers (usable as case labels)
+		inline constexpr std::uint32_t toOpcode(const char* label)
+		{
+			return (static_cast<std::uint32_t>(static_cast<std::uint8_t>(label[0])) << 24)
+			     | (static_cast<std::uint32_t>(static_cast<std::uint8_t>(label[1])) << 16)
+			     | (static_cast<std::uint32_t>(static_cast<std::uint8_t>(label[2])) << 8)
+			     |  static_cast<std::uint32_t>(static_cast<std::uint8_t>(label[3]));
+		}
+
 		template<typename CommandType>
 		class InboundCommand
 		{
@@ -35,8 +45,6 @@ namespace slim
 
 			public:
 				InboundCommand(const util::buffer::Ring<std::uint8_t>& commandRingBuffer, const std::string_view& label)
-				// TODO: buffer size must be calculated based on size provided in the command
-				: buffer{commandRingBuffer.getCapacity()}
 				{
 					// validating provided data is sufficient for the fixed part of the command
 					if (sizeof(CommandType) > commandRingBuffer.getSize())
@@ -50,39 +58,27 @@ namespace slim
 						throw slim::Exception("Message is too small for CommandType command");
 					}
 
-					// serializing fixed part of the command
-					for (std::size_t i{0}; i < sizeof(CommandType); i++)
-					{
-						buffer.getData()[i] = commandRingBuffer[i];
-					}
-
-					// TODO: refactor
-					auto* commandPtr{(CommandType*)buffer.getData()};
+					// fixed part of the command is decoded straight into the (packed) command structure with at most two copies,
+					// so there is no heap allocation; dynamic part of the command is not used hence it is not copied
+					commandRingBuffer.copy(0, reinterpret_cast<std::uint8_t*>(&command), sizeof(CommandType));
 
 					// converting command size data
-					commandPtr->size = ntohl(commandPtr->size);
+					command.size = ntohl(command.size);
 
-					// validating length attribute from the command (last byte accounts for tailing zero)
-					auto messageSize{commandPtr->size + sizeof(commandPtr->opcode) + sizeof(commandPtr->size)};
-					if (messageSize > buffer.getSize())
+					// validating length attribute from the command
+					auto messageSize{command.size + sizeof(command.opcode) + sizeof(command.size)};
+					if (messageSize > commandRingBuffer.getCapacity())
 					{
 						throw slim::Exception("Length provided in CommandType command is too big");
 					}
 
-					// serializing dynamic part of the command
-					for (std::size_t i{sizeof(CommandType)}; i < messageSize; i++)
-					{
-						buffer.getData()[i] = commandRingBuffer[i];
-					}
-
 					// validating there is command label present
-					std::string s{commandPtr->opcode, sizeof(commandPtr->opcode)};
-					if (label.compare(s))
+					if (label.compare(std::string_view{command.opcode, sizeof(command.opcode)}))
 					{
 						throw slim::Exception("Missing 'TODO: <label>' label in the header");
 					}
 
-					getData()->convert();
+					command.convert();
 				}
 
  				// using Rule Of Zero
@@ -94,13 +90,13 @@ namespace slim
 
 				auto* getData()
 				{
-					return (CommandType*)buffer.getData();
+					return &command;
 				}
 
 				auto getSize()
 				{
 					// TODO: refactor
-					return getData()->size + sizeof(SizeElement) + 4;
+					return command.size + sizeof(SizeElement) + 4;
 				}
 
 				inline static auto isEnoughData(const util::buffer::Ring<std::uint8_t>& rinBuffer)
@@ -112,10 +108,7 @@ namespace slim
 					if (labelOffset + sizeof(SizeElement) <= rinBuffer.getSize())
 					{
 						SizeElement sizeElement;
-						for (auto i{std::size_t{0}}; i < sizeof(SizeElement); i++)
-						{
-							sizeElement.array[i] = rinBuffer[i + labelOffset];
-						}
+						rinBuffer.copy(labelOffset, sizeElement.array, sizeof(SizeElement));
 
 						// there is enough data in the buffer if provided length is less of equal to the buffer size
 						result = (labelOffset + sizeof(sizeElement.size) + ntohl(sizeElement.size) <= rinBuffer.getSize());
@@ -127,13 +120,8 @@ namespace slim
 			protected:
 				InboundCommand() = default;
 
-				inline auto& getBuffer()
-				{
-					return buffer;
-				}
-
 			private:
-				util::buffer::HeapBuffer<std::uint8_t> buffer;
+				CommandType command;
 		};
 	}
 }
@@ -13,6 +13,8 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <charconv>    // std::from_chars
 #include <chrono>
 #include <conwrap2/ProcessorProxy.hpp>
 #include <cstddef>     // std::size_t
@@ -23,7 +25,7 @@
 #include <string>
 #include <type_safe/optional.hpp>
 #include <type_safe/optional_ref.hpp>
-#include <type_traits> // std::remove_reference
+#include <type_traits> // std::is_same, std::remove_reference
 #include <unordered_map>
 #include <vector>
 
@@ -34,11 +36,13 @@
 #include "slim/Exception.hpp"
 #include "slim/log/log.hpp"
 #include "slim/proto/CommandSession.hpp"
+#include "slim/proto/EncodingStage.hpp"
 #include "slim/proto/StreamingSession.hpp"
 #include "slim/util/BigInteger.hpp"
 #include "slim/util/Duration.hpp"
 #include "slim/util/StateMachine.hpp"
 #include "slim/util/Timestamp.hpp"
+#include "slim/util/buffer/Ring.hpp"
 
 
 namespace slim
@@ -76,51 +80,53 @@ namespace slim
 				StoppedState,
 			};
 
+			// state machine uses transition table provided by getTransitions()
+			friend util::StateMachine<Streamer, Event, State>;
+
 			public:
-				Streamer(conwrap2::ProcessorProxy<std::unique_ptr<ContainerBase>> pp, unsigned int sp, EncoderBuilder eb, ts::optional<unsigned int> ga)
+				// sessions lagging behind the stream by more than history size (in chunks) are dropped
+				Streamer(conwrap2::ProcessorProxy<std::unique_ptr<ContainerBase>> pp, unsigned int sp, EncoderBuilder eb, ts::optional<unsigned int> ga, std::size_t hs = 50, bool ae = false)
 				: Consumer{pp}
 				, streamingPort{sp}
 				, encoderBuilder{eb}
+				, encodingStage{eb, ae}
 				, gain{ga}
-				, stateMachine
-				{
-					StoppedState,  // initial state
-					{   // transition table definition
-						{StartEvent,   StartedState,   StartedState,   [&](auto event) {},                          [&] {return true;}},
-						{StartEvent,   PreparingState, PreparingState, [&](auto event) {},                          [&] {return true;}},
-						{StartEvent,   BufferingState, BufferingState, [&](auto event) {},                          [&] {return true;}},
-						{StartEvent,   PlayingState,   PlayingState,   [&](auto event) {},                          [&] {return true;}},
-						{StartEvent,   DrainingState,  DrainingState,  [&](auto event) {},                          [&] {return true;}},
-						{StartEvent,   StoppedState,   StartedState,   [&](auto event) {},                          [&] {return true;}},
-						{PrepareEvent, StartedState,   PreparingState, [&](auto event) {stateChangeToPreparing();}, [&] {return true;}},
-						{PrepareEvent, PreparingState, PreparingState, [&](auto event) {},                          [&] {return true;}},
-						{BufferEvent,  PreparingState, BufferingState, [&](auto event) {stateChangeToBuffering();}, [&] {return isReadyToBuffer();}},
-						{BufferEvent,  BufferingState, BufferingState, [&](auto event) {},                          [&] {return true;}},
-						{BufferEvent,  PlayingState,   PlayingState,   [&](auto event) {},                          [&] {return true;}},
-						{PlayEvent,    BufferingState, PlayingState,   [&](auto event) {stateChangeToPlaying();},   [&] {return isReadyToPlay();}},
-						{PlayEvent,    PlayingState,   PlayingState,   [&](auto event) {},                          [&] {return true;}},
-						{DrainEvent,   PreparingState, DrainingState,  [&](auto event) {},                          [&] {return true;}},
-						{DrainEvent,   BufferingState, DrainingState,  [&](auto event) {},                          [&] {return true;}},
-						{DrainEvent,   PlayingState,   DrainingState,  [&](auto event) {},                          [&] {return true;}},
-						{DrainEvent,   DrainingState,  DrainingState,  [&](auto event) {},                          [&] {return true;}},
-						{DrainEvent,   StartedState,   StartedState,   [&](auto event) {},                          [&] {return true;}},
-						{FlushedEvent, StartedState,   StartedState,   [&](auto event) {},                          [&] {return true;}},
-						{FlushedEvent, PlayingState,   PlayingState,   [&](auto event) {},                          [&] {return true;}},
-						{FlushedEvent, DrainingState,  StartedState,   [&](auto event) {},                          [&] {return !isDraining();}},
-						{StopEvent,    StoppedState,   StoppedState,   [&](auto event) {},                          [&] {return true;}},
-						{StopEvent,    StartedState,   StoppedState,   [&](auto event) {stateChangeToStopped();},   [&] {return true;}},
-						{StopEvent,    PreparingState, StoppedState,   [&](auto event) {stateChangeToStopped();},   [&] {return true;}},
-						{StopEvent,    BufferingState, StoppedState,   [&](auto event) {stateChangeToStopped();},   [&] {return true;}},
-						{StopEvent,    PlayingState,   StoppedState,   [&](auto event) {stateChangeToStopped();},   [&] {return true;}},
-						{StopEvent,    DrainingState,  StoppedState,   [&](auto event) {stateChangeToStopped();},   [&] {return true;}},
-					}
-				}
+				, stateMachine{*this, StoppedState}
+				, history{hs}
 				{
+					// encoding worker thread only notifies processor thread, which collects encoded chunks in submission order
+					encodingStage.setReadyCallback([&, processorProxy = pp, alive = std::weak_ptr<bool>{alivePtr}]() mutable
+					{
+						processorProxy.process([&, alive]
+						{
+							if (alive.lock())
+							{
+								collectEncodedChunks();
+
+								// resuming the scheduler which is waiting for the encoding stage to accept a chunk
+								if (waitingForEncoder)
+								{
+									waitingForEncoder = false;
+									notifyReady();
+								}
+							}
+						});
+					});
+
 					LOG(DEBUG) << LABELS{"proto"} << "Streamer object was created (id=" << this << ")";
 				}
 
 				virtual ~Streamer()
 				{
+					// pending notifications from the encoding worker thread must not reach a deleted object
+					alivePtr.reset();
+
+					// canceling deferred operation
+					ts::with(retryTimer, [&](auto& timer)
+					{
+						timer.cancel();
+					});
+
 					LOG(DEBUG) << LABELS{"proto"} << "Streamer object was deleted (id=" << this << ")";
 				}
 
@@ -221,7 +227,8 @@ namespace slim
 							result = streamChunk(chunk);
 						}
 
-						if (samplingRate != chunkSamplingRate || chunk.endOfStream)
+						// the last chunk must be accepted by the encoding stage before draining starts
+						if (samplingRate != chunkSamplingRate || (chunk.endOfStream && result))
 						{
 							// changing state to Draining
 							stateMachine.processEvent(DrainEvent, [&](auto event, auto state)
@@ -237,6 +244,13 @@ namespace slim
 
 					if (stateMachine.state == DrainingState)
 					{
+						// lagging sessions keep consuming the tail of the stream while draining
+						collectEncodedChunks();
+						deliverChunks();
+
+						// chunk which is waiting for draining to finish is the first chunk of the next stream
+						nextSamplingRate = chunkSamplingRate;
+
 						// 'trying' to transition to Running state which will succeed only when all SlimProto sessions are in Running state
 						result = stateMachine.processEvent(FlushedEvent, [&](auto event, auto state)
 						{
@@ -250,6 +264,11 @@ namespace slim
 						}
 					}
 
+					if (!result)
+					{
+						deferChunk();
+					}
+
 					return result;
 				}
 
@@ -313,7 +332,7 @@ namespace slim
 					{
 						// if there is a relevant SlimProto session then reset the reference
 						auto clientID{(*found).second->getClientID()};
-						if (auto commandSession{findSessionByID(commandSessions, clientID)}; commandSession.has_value())
+						if (auto commandSession{findSessionByClientID(clientID)}; commandSession.has_value())
 						{
 							commandSession.value()->setStreamingSession(ts::nullopt);
 						}
@@ -343,15 +362,12 @@ namespace slim
 
 						LOG(INFO) << LABELS{"proto"} << "Client ID was parsed (clientID=" << clientID.value() << ")";
 
-						// setting encoder sampling rate
-						encoderBuilder.setSamplingRate(samplingRate);
-
-						// creating streaming session object
-						auto streamingSessionPtr{std::make_unique<StreamingSessionType>(getProcessorProxy(), std::ref(connection), std::ref(*this), clientID.value(), encoderBuilder)};
-						streamingSessionPtr->start();
+						// creating streaming session object; encoding is done once by the encoding stage for all sessions
+						auto streamingSessionPtr{std::make_unique<StreamingSessionType>(getProcessorProxy(), std::ref(connection), std::ref(*this), clientID.value(), encoderBuilder.getMIME(), samplingRate)};
+						streamingSessionPtr->start(encodingStage.getHeader());
 
 						// saving HTTP session reference in the relevant SlimProto session
-						auto commandSession{findSessionByID(commandSessions, clientID.value())};
+						auto commandSession{findSessionByClientID(clientID.value())};
 						if (!commandSession.has_value())
 						{
 							connection.stop();
@@ -378,7 +394,7 @@ namespace slim
 
 					if (auto found{commandSessions.find(&connection)}; found != commandSessions.end())
 					{
-						sessionToChunkSequenceMap.erase((*found).second.get());
+						sessionCursors.erase(&connection);
 						removeSession(commandSessions, *(*found).first, *(*found).second);
 					}
 					else
@@ -415,11 +431,11 @@ namespace slim
 					ss << (++nextID);
 
 					// creating command session object
-					auto commandSessionPtr{std::make_unique<CommandSessionType>(getProcessorProxy(), std::ref(connection), std::ref(*this), ss.str(), streamingPort, encoderBuilder.getFormat(), gain)};
+					auto commandSessionPtr{std::make_unique<CommandSessionType>(getProcessorProxy(), std::ref(connection), std::ref(*this), ss.str(), streamingPort, encoderBuilder.getFormat(), encoderBuilder.getEncodedBitsPerSample(), gain)};
 					commandSessionPtr->start();
 
-					// saving data about command session in the maps
-					sessionToChunkSequenceMap.emplace(commandSessionPtr.get(), streamedChunks);
+					// saving data about command session in the maps; a new session starts reading from the next chunk
+					sessionCursors.emplace(&connection, SessionCursor{commandSessionPtr.get(), streamedChunks, false});
 					addSession(commandSessions, connection, std::move(commandSessionPtr));
 				}
 
@@ -447,7 +463,18 @@ namespace slim
 				}
 
 			protected:
-				using SessionToChunkSequenceMap = std::unordered_map<CommandSessionType*, util::BigInteger>;
+				// cursor is a sequence number of the next chunk a session should consume
+				struct SessionCursor
+				{
+					CommandSessionType* sessionPtr;
+					util::BigInteger    position;
+					bool                dropped;  // lagging session which is waiting for its connection to be closed
+				};
+
+				// cursors are indexed by connection the same way as sessions, so a session is reachable from its cursor
+				using SessionCursorsMap = std::unordered_map<ConnectionType*, SessionCursor>;
+				// client ID's are generated from a counter, so they are indexed by their numeric value
+				using ClientIDIndexMap  = std::unordered_map<util::BigInteger, CommandSessionType*>;
 
 				template<typename SessionType>
 				inline auto& addSession(SessionsMap<SessionType>& sessions, ConnectionType& connection, std::unique_ptr<SessionType> sessionPtr)
@@ -461,6 +488,15 @@ namespace slim
 
 						// saving session in a map; using pointer to a relevant connection as an ID
 						sessions[&connection] = std::move(sessionPtr);
+
+						// SlimProto sessions are also indexed by client ID so HTTP sessions can be correlated in O(1)
+						if constexpr (std::is_same<SessionType, CommandSessionType>::value)
+						{
+							if (auto clientID{toNumericClientID(s->getClientID())}; clientID.has_value())
+							{
+								clientIDIndex[clientID.value()] = s;
+							}
+						}
 						LOG(DEBUG) << LABELS{"proto"} << "New session was added (id=" << s << ", sessions=" << sessions.size() << ")";
 					}
 					else
@@ -509,6 +545,71 @@ namespace slim
 					return bufferingStartedAt + getBufferingDuration(util::milliseconds);
 				}
 
+				inline void clearHistory()
+				{
+					// releasing references to encoded chunks as clearing a ring does not destroy its elements
+					for (std::size_t i = 0; i < history.getSize(); i++)
+					{
+						history[i].reset();
+					}
+					history.clear();
+					historyStart = 0;
+				}
+
+				inline void collectEncodedChunks()
+				{
+					encodingStage.collect([&](auto& encodedChunkPtr)
+					{
+						streamEncodedChunk(encodedChunkPtr);
+					});
+				}
+
+				inline void deliverChunks()
+				{
+					// every session consumes chunks from the history at its own pace, so a slow client does not hold back others
+					for (auto& [connectionPtr, cursor] : sessionCursors)
+					{
+						while (!cursor.dropped && cursor.position < streamedChunks && cursor.sessionPtr->consumeChunk(*history[static_cast<std::size_t>(cursor.position - historyStart)]))
+						{
+							cursor.position++;
+						}
+					}
+				}
+
+				inline void deferChunk()
+				{
+					// encoding stage signals once its worker is done, so only waiting for clients requires a delayed retry
+					if (encodingStage.hasPendingChunks())
+					{
+						waitingForEncoder = true;
+					}
+					else if (!retryTimer.has_value())
+					{
+						retryTimer = ts::ref(getProcessorProxy().processWithDelay([&]
+						{
+							// releasing timer so a new 'delayed' request may be issued
+							retryTimer.reset();
+							notifyReady();
+						}, std::chrono::milliseconds{10}));
+					}
+				}
+
+				inline void dropLaggingSessions()
+				{
+					for (auto& [connectionPtr, cursor] : sessionCursors)
+					{
+						// if a chunk required by a session was evicted from the history then this session can not catch up
+						if (!cursor.dropped && cursor.position < historyStart)
+						{
+							LOG(WARNING) << LABELS{"proto"} << "Closing SlimProto session as it lags behind the stream by more than " << history.getCapacity() << " chunks (clientID=" << cursor.sessionPtr->getClientID() << ")";
+
+							// no more chunks are delivered to this session; it is removed once its connection is closed
+							cursor.dropped = true;
+							connectionPtr->stop();
+						}
+					}
+				}
+
 				inline auto durationToFrames(const util::Duration& duration) const
  				{
 					auto result{util::BigInteger{0}};
@@ -521,25 +622,16 @@ namespace slim
 					return result;
  				}
 
-				template<typename SessionType>
-				auto findSessionByID(SessionsMap<SessionType>& sessions,  std::string clientID)
+				inline auto findSessionByClientID(const std::string& clientID)
 				{
-					auto result{ts::optional<SessionType*>{ts::nullopt}};
-					auto found{std::find_if(sessions.begin(), sessions.end(), [&](auto& entry) -> bool
-					{
-						auto found{false};
+					auto result{ts::optional<CommandSessionType*>{ts::nullopt}};
 
-						if (entry.second->getClientID() == clientID)
+					if (auto numericClientID{toNumericClientID(clientID)}; numericClientID.has_value())
+					{
+						if (auto found{clientIDIndex.find(numericClientID.value())}; found != clientIDIndex.end())
 						{
-							found = true;
+							result = (*found).second;
 						}
-
-						return found;
-					})};
-
-					if (found != sessions.end())
-					{
-						result = (*found).second.get();
 					}
 
 					return result;
@@ -557,6 +649,50 @@ namespace slim
 					return result;
 				}
 
+				static constexpr auto getTransitions()
+				{
+					// transition table definition; it is converted into a lookup matrix at compile time
+					return std::array<util::Transition<Streamer, Event, State>, 27>
+					{{
+						{StartEvent,   StartedState,   StartedState,   nullptr,                           nullptr},
+						{StartEvent,   PreparingState, PreparingState, nullptr,                           nullptr},
+						{StartEvent,   BufferingState, BufferingState, nullptr,                           nullptr},
+						{StartEvent,   PlayingState,   PlayingState,   nullptr,                           nullptr},
+						{StartEvent,   DrainingState,  DrainingState,  nullptr,                           nullptr},
+						{StartEvent,   StoppedState,   StartedState,   nullptr,                           nullptr},
+						{PrepareEvent, StartedState,   PreparingState, &Streamer::stateChangeToPreparing, nullptr},
+						{PrepareEvent, PreparingState, PreparingState, nullptr,                           nullptr},
+						{BufferEvent,  PreparingState, BufferingState, &Streamer::stateChangeToBuffering, &Streamer::isReadyToBuffer},
+						{BufferEvent,  BufferingState, BufferingState, nullptr,                           nullptr},
+						{BufferEvent,  PlayingState,   PlayingState,   nullptr,                           nullptr},
+						{PlayEvent,    BufferingState, PlayingState,   &Streamer::stateChangeToPlaying,   &Streamer::isReadyToPlay},
+						{PlayEvent,    PlayingState,   PlayingState,   nullptr,                           nullptr},
+						{DrainEvent,   PreparingState, DrainingState,  nullptr,                           nullptr},
+						{DrainEvent,   BufferingState, DrainingState,  nullptr,                           nullptr},
+						{DrainEvent,   PlayingState,   DrainingState,  nullptr,                           nullptr},
+						{DrainEvent,   DrainingState,  DrainingState,  nullptr,                           nullptr},
+						{DrainEvent,   StartedState,   StartedState,   nullptr,                           nullptr},
+						{FlushedEvent, StartedState,   StartedState,   nullptr,                           nullptr},
+						{FlushedEvent, PlayingState,   PlayingState,   nullptr,                           nullptr},
+						{FlushedEvent, DrainingState,  StartedState,   &Streamer::stateChangeToStarted,   &Streamer::isDrained},
+						{StopEvent,    StoppedState,   StoppedState,   nullptr,                           nullptr},
+						{StopEvent,    StartedState,   StoppedState,   &Streamer::stateChangeToStopped,   nullptr},
+						{StopEvent,    PreparingState, StoppedState,   &Streamer::stateChangeToStopped,   nullptr},
+						{StopEvent,    BufferingState, StoppedState,   &Streamer::stateChangeToStopped,   nullptr},
+						{StopEvent,    PlayingState,   StoppedState,   &Streamer::stateChangeToStopped,   nullptr},
+						{StopEvent,    DrainingState,  StoppedState,   &Streamer::stateChangeToStopped,   nullptr},
+					}};
+				}
+
+				inline bool isDrained()
+				{
+					// every session (except dropped ones) must receive the whole stream, including its end
+					return !encodingStage.hasPendingChunks() && !isDraining() && std::all_of(sessionCursors.begin(), sessionCursors.end(), [&](auto& entry)
+					{
+						return entry.second.dropped || entry.second.position == streamedChunks;
+					});
+				}
+
 				inline auto isReadyToBuffer()
 				{
 					auto result{false};
@@ -608,8 +744,17 @@ namespace slim
 				template<typename SessionsType, typename SessionType>
 				inline void removeSession(SessionsType& sessions, ConnectionType& connection, SessionType& session)
 				{
-					session.stop([&sessions = sessions, &connection = connection, &session = session]
+					session.stop([&, &sessions = sessions, &connection = connection, &session = session]
 					{
+						// removing index entry before the session is deleted
+						if constexpr (std::is_same<SessionType, CommandSessionType>::value)
+						{
+							if (auto found{clientIDIndex.find(toNumericClientID(session.getClientID()).value_or(-1))}; found != clientIDIndex.end() && (*found).second == &session)
+							{
+								clientIDIndex.erase(found);
+							}
+						}
+
 						if (sessions.erase(&connection))
 						{
 							LOG(DEBUG) << LABELS{"proto"} << "Session was removed (id=" << &session << ", total sessions=" << sessions.size() << ")";
@@ -621,6 +766,20 @@ namespace slim
 					});
 				}
 
+				static auto toNumericClientID(const std::string& clientID)
+				{
+					auto result{ts::optional<util::BigInteger>{ts::nullopt}};
+					auto value{util::BigInteger{0}};
+
+					// leading digits are used, so a client ID parsed from an HTTP request line may contain a tail
+					if (auto [end, error]{std::from_chars(clientID.data(), clientID.data() + clientID.size(), value)}; error == std::errc{} && end != clientID.data())
+					{
+						result = value;
+					}
+
+					return result;
+				}
+
 				inline void stateChangeToBuffering()
 				{
 					// buffering start time is required for calculating min buffering time
@@ -648,12 +807,16 @@ namespace slim
                     bufferedFrames     = 0;
 					streamedChunks     = 0;
 
-					// resetting chunk sequence for all sessions
-					for (auto& entry : sessionToChunkSequenceMap)
+					// resetting history and cursors for all sessions
+					clearHistory();
+					for (auto& entry : sessionCursors)
 					{
-						entry.second = 0;
+						entry.second.position = 0;
 					}
 
+					// encoder is started before sessions are prepared so the stream header is available for all streaming sessions
+					encodingStage.start(samplingRate);
+
 					for (auto& entry : commandSessions)
 					{
 						entry.second->prepare(samplingRate);
@@ -662,8 +825,18 @@ namespace slim
 					LOG(DEBUG) << LABELS{"proto"} << "Preparing to stream started";
 				}
 
+				inline void stateChangeToStarted()
+				{
+					// the next stream's encoder is initialized while there is no stream
+					encodingStage.stop();
+					encodingStage.prewarm(nextSamplingRate);
+				}
+
 				inline void stateChangeToStopped()
 				{
+					clearHistory();
+					encodingStage.stop();
+
 					for (auto& entry : commandSessions)
 					{
 						entry.second->stop([] {});
@@ -676,50 +849,68 @@ namespace slim
 
 				inline bool streamChunk(Chunk& chunk)
 				{
-					auto result = true;
+					if (chunk.droppedFrames > 0)
+					{
+						LOG(WARNING) << LABELS{"proto"} << "Capture overrun: " << chunk.droppedFrames << " frame(s) were lost before chunk (captured frames=" << chunk.capturedFrames << ")";
+					}
 
-					// sending chunk to all SlimProto sessions
-					for (auto& entry : sessionToChunkSequenceMap)
+					// encoded chunk is added to the history once the worker thread is done with it
+					if (encodingStage.isAsynchronous())
 					{
-						if (entry.second <= streamedChunks)
-						{
-							if (entry.first->consumeChunk(chunk))
-							{
-								entry.second++;
-							}
-							else
-							{
-								result = false;
-							}
-						}
+						// if the worker thread is behind then the chunk stays in the capture queue and is resubmitted later
+						auto result{encodingStage.submit(chunk)};
+						collectEncodedChunks();
+
+						return result;
 					}
 
-					// increasing counters
-					if (result)
+					streamEncodedChunk(std::make_shared<const EncodedChunk>(encodingStage.encode(chunk)));
+
+					// chunk is always consumed so that capture queue keeps flowing regardless of slow clients
+					return true;
+				}
+
+				inline void streamEncodedChunk(EncodedChunkPtr encodedChunkPtr)
+				{
+					// chunk is encoded only once and then it is referenced by the history until all sessions consume it or it is evicted
+					if (history.isFull())
 					{
-						streamedChunks++;
-						streamedFrames += chunk.frames;
+						historyStart++;
 					}
 
-					return result;
+					// increasing counters
+					streamedChunks++;
+					streamedFrames += encodedChunkPtr->frames;
+					history.push(std::move(encodedChunkPtr));
+
+					dropLaggingSessions();
+					deliverChunks();
 				}
 
 			private:
-				unsigned int                      streamingPort;
-				EncoderBuilder                    encoderBuilder;
-				ts::optional<unsigned int>        gain;
-				util::StateMachine<Event, State>  stateMachine;
-				util::BigInteger                  nextID{0};
-				SessionsMap<CommandSessionType>   commandSessions;
-				SessionsMap<StreamingSessionType> streamingSessions;
-				SessionToChunkSequenceMap         sessionToChunkSequenceMap;
-				unsigned int                      samplingRate{0};
-				util::Timestamp                   preparingStartedAt;
-				util::Timestamp                   bufferingStartedAt;
-				util::Timestamp                   playbackStartedAt;
-				util::BigInteger                  streamedChunks{0};
-				util::BigInteger                  streamedFrames{0};
-				util::BigInteger                  bufferedFrames{0};
+				unsigned int                               streamingPort;
+				EncoderBuilder                             encoderBuilder;
+				EncodingStage                              encodingStage;
+				ts::optional<unsigned int>                 gain;
+				util::StateMachine<Streamer, Event, State> stateMachine;
+				util::BigInteger                           nextID{0};
+				SessionsMap<CommandSessionType>            commandSessions;
+				SessionsMap<StreamingSessionType>          streamingSessions;
+				SessionCursorsMap                          sessionCursors;
+				ClientIDIndexMap                           clientIDIndex;
+				util::buffer::Ring<EncodedChunkPtr>        history;
+				util::BigInteger                           historyStart{0};
+				unsigned int                               samplingRate{0};
+				unsigned int                               nextSamplingRate{0};
+				util::Timestamp                            preparingStartedAt;
+				util::Timestamp                            bufferingStartedAt;
+				util::Timestamp                            playbackStartedAt;
+				util::BigInteger                           streamedChunks{0};
+				util::BigInteger                           streamedFrames{0};
+				util::BigInteger                           bufferedFrames{0};
+				bool                                       waitingForEncoder{false};
+				ts::optional_ref<conwrap2::Timer>          retryTimer{ts::nullopt};
+				std::shared_ptr<bool>                      alivePtr{std::make_shared<bool>(true)};
 		};
 	}
 }
@@ -12,23 +12,26 @@
 
 #pragma once
 
-#include <algorithm>  // std::min
 #include <conwrap2/ProcessorProxy.hpp>
-#include <cstring>  // std::memcpy
+#include <algorithm>  // std::min
+#include <chrono>
+#include <cstddef>    // std::size_t
+#include <cstring>    // std::memcpy
+#include <deque>
 #include <functional>
-#include <queue>
 #include <memory>
 #include <scope_guard.hpp>
-#include <sstream>  // std::stringstream
+#include <sstream>    // std::stringstream
 #include <string>
 #include <type_safe/optional.hpp>
+#include <vector>
 
-#include "slim/Chunk.hpp"
-#include "slim/EncoderBase.hpp"
-#include "slim/EncoderBuilder.hpp"
 #include "slim/log/log.hpp"
+#include "slim/proto/EncodingStage.hpp"
+#include "slim/util/AsyncWriter.hpp"
 #include "slim/util/BigInteger.hpp"
-#include "slim/util/buffer/BufferPool.hpp"
+#include "slim/util/Duration.hpp"
+#include "slim/util/Timestamp.hpp"
 
 
 namespace slim
@@ -41,39 +44,15 @@ namespace slim
 		class StreamingSession
 		{
 			public:
-				StreamingSession(conwrap2::ProcessorProxy<std::unique_ptr<ContainerBase>> pp, std::reference_wrapper<ConnectionType> co, std::reference_wrapper<StreamerType> st, std::string id, EncoderBuilder eb)
+				StreamingSession(conwrap2::ProcessorProxy<std::unique_ptr<ContainerBase>> pp, std::reference_wrapper<ConnectionType> co, std::reference_wrapper<StreamerType> st, std::string id, std::string mm, unsigned int sr)
 				: processorProxy{pp}
 				, connection{co}
 				, streamer{st}
 				, clientID{id}
+				, mime{mm}
+				, samplingRate{sr}
 				{
 					LOG(DEBUG) << LABELS{"proto"} << "HTTP session object was created (id=" << this << ")";
-
-					eb.setEncodedCallback([&](const auto* encodedData, auto encodedDataSize)
-					{
-						for (std::size_t offset = 0, chunkSize; offset < encodedDataSize; offset += chunkSize)
-						{
-							auto pooledBuffer = bufferPool.allocate();
-							if (!pooledBuffer.getData())
-							{
-								LOG(WARNING) << LABELS{"proto"} << "Transfer buffer is full - skipping encoded chunk";
-								return;
-							}
-
-							// copying encoded PCM content to the allocated buffer and submitting for transfer to a client
-							chunkSize = std::min(pooledBuffer.getSize(), encodedDataSize - offset);
-							std::memcpy(pooledBuffer.getData(), encodedData + offset, chunkSize);
-							auto transferDataChunk = TransferDataChunk{std::move(pooledBuffer), chunkSize, 0};
-
-							// submitting a chunk to be transferred to a client
-							transferBufferQueue.push(std::move(transferDataChunk));
-							processorProxy.process([&]
-							{
-								transferTask();
-							});
-						}
-					});
-					encoderPtr = std::move(eb.build());
 				}
 
 				~StreamingSession()
@@ -92,34 +71,33 @@ namespace slim
 				StreamingSession(StreamingSession&& rhs) = delete;              // non-movable
 				StreamingSession& operator=(StreamingSession&& rhs) = delete;   // non-movable-assignable
 
-				inline bool consumeChunk(const Chunk& chunk)
+				inline bool consumeChunk(const EncodedChunk& chunk)
 				{
-					if (running)
+					if (running && !stopping)
 					{
-						// TODO: configure
-						// if no enough place in the buffer then signalling that chunk was not consumed (streamer will redeliver this chunk)
-						if (bufferPool.getAvailableSize() < 10)
+						// if no enough place in the transfer queue then signalling that chunk was not consumed (streamer will redeliver this chunk)
+						if (maxQueuedBytes <= queuedBytes)
 						{
 							return false;
 						}
 
 						// sampling rates do not match then stopping this session
-						if (chunk.samplingRate != encoderPtr->getSamplingRate())
+						if (chunk.samplingRate != samplingRate)
 						{
 							// stopping this session due to incorrect data provided
-							LOG(WARNING) << LABELS{"proto"} << "Closing HTTP connection due to different sampling rate used by a client (session rate=" << encoderPtr->getSamplingRate() << "; data rate=" << chunk.samplingRate << ")";
+							LOG(WARNING) << LABELS{"proto"} << "Closing HTTP connection due to different sampling rate used by a client (session rate=" << samplingRate << "; data rate=" << chunk.samplingRate << ")";
 							stop([] {});
 							return true;
 						}
 
-						// if this is the last chunk for the ongoing stream then stopping this session
+						submitSegments(chunk.segments);
+						framesProvided += chunk.frames;
+
+						// if this is the last chunk for the ongoing stream then stopping this session; encoded tail of the stream is already queued
 						if (chunk.endOfStream)
 						{
-							stop([] {});
+							stop([] {}, true);
 						}
-
-						encoderPtr->encode(chunk.buffer.getData(), chunk.frames * chunk.bytesPerSample * chunk.channels);
-						framesProvided += chunk.frames;
 					}
 
 					return true;
@@ -142,7 +120,7 @@ namespace slim
 
 				inline void onRequest(unsigned char* data, std::size_t size)
 				{
-					if (running)
+					if (running && !stopping)
 					{
 						// TODO: make more strick validation
 						std::string get{"GET"};
@@ -170,9 +148,8 @@ namespace slim
 					return result;
 				}
 
-				inline void start()
+				inline void start(const EncodedSegments& header)
 				{
-					encoderPtr->start();
 					running = true;
 
 					// creating response string
@@ -183,68 +160,146 @@ namespace slim
 					   << VERSION
 					   << ")\r\n"
 					   << "Connection: close\r\n"
-					   << "Content-Type: " << encoderPtr->getMIME() << "\r\n"
+					   << "Content-Type: " << mime << "\r\n"
 					   << "\r\n";
 
-					// sending response string
-					connection.get().write(ss.str());
+					// response is queued ahead of the stream header, so it is sent by the first gather write instead of a blocking write
+					auto response{ss.str()};
+					auto responsePtr{std::make_shared<EncodedSegment>(response.size())};
+					std::memcpy(responsePtr->getData(), response.data(), response.size());
+					submitSegments(EncodedSegments{std::move(responsePtr)});
+
+					// stream header produced by the encoder is required for a client joining an ongoing stream
+					submitSegments(header);
 				}
 
+				// queued data is dropped; only a write which is already in progress is completed
 				template <typename CallbackType>
 				inline void stop(CallbackType callback)
 				{
-					if (running)
+					stop(std::move(callback), false);
+				}
+
+			protected:
+				struct TransferDataChunk
+				{
+					EncodedSegmentPtr segmentPtr;
+					std::size_t       offset;
+				};
+
+				inline void dropQueuedSegments()
+				{
+					// segments referenced by an ongoing write must outlive it
+					while (transferBufferQueue.size() > (transferring ? transferringChunks : 0))
 					{
-						encoderPtr->stop([&, callback = std::move(callback)]
-						{
-							flush([&, callback = std::move(callback)]
-							{
-								running = false;
+						queuedBytes -= transferBufferQueue.back().segmentPtr->getSize();
+						transferBufferQueue.pop_back();
+					}
+				}
 
-								// stopping connection will submit a onClose handler
-								connection.get().stop();
+				inline void flush(util::Timestamp deadline)
+				{
+					// a client which does not consume the tail of the stream in time loses it
+					if (deadline < util::Timestamp::now() && transferBufferQueue.size() > (transferring ? transferringChunks : 0))
+					{
+						LOG(WARNING) << LABELS{"proto"} << "Dropping " << queuedBytes << " queued byte(s) as HTTP client did not consume them in time (clientID=" << clientID << ")";
+						dropQueuedSegments();
+					}
 
-								// submiting a new handler is required to run a callback after onClose handler is processed
-								processorProxy.process([callback = std::move(callback)]
-								{
-									callback();
-								});
-							});
+					// transfer task removes chunks from the queue even if connection is broken, so waiting until the queue is empty
+					if (!transferring && transferBufferQueue.empty())
+					{
+						timer.reset();
+						running  = false;
+						stopping = false;
+
+						// stopping connection will submit a onClose handler
+						connection.get().stop();
+
+						// submiting a new handler is required to run callbacks after onClose handler is processed
+						processorProxy.process([callbacks = std::move(stopCallbacks)]
+						{
+							for (auto& callback : callbacks)
+							{
+								callback();
+							}
 						});
+						stopCallbacks.clear();
 					}
 					else
+					{
+						// waiting until data is transferred
+						timer = ts::ref(processorProxy.processWithDelay([&, deadline]
+						{
+							flush(deadline);
+						}, std::chrono::milliseconds{1}));
+					}
+				}
+
+				// end of stream is delivered within a deadline; any other stop delivers only data, which is being written
+				template <typename CallbackType>
+				inline void stop(CallbackType callback, bool drain)
+				{
+					if (!running)
 					{
 						callback();
+						return;
+					}
+
+					// a session may be stopped again while it is stopping; all callbacks are invoked once it is stopped
+					stopCallbacks.emplace_back(std::move(callback));
+					if (!drain)
+					{
+						dropQueuedSegments();
+					}
+
+					if (!stopping)
+					{
+						stopping = true;
+						flush(util::Timestamp::now() + drainTimeout);
 					}
 				}
 
-			protected:
-				using PooledBufferType = util::buffer::BufferPool<std::uint8_t>::PooledBufferType;
-				struct TransferDataChunk
+				inline void popTransferDataChunk()
 				{
-					PooledBufferType           buffer;
-					PooledBufferType::SizeType size;
-					PooledBufferType::SizeType offset;
-				};
+					queuedBytes -= transferBufferQueue.front().segmentPtr->getSize();
+					transferBufferQueue.pop_front();
+				}
 
-				template <typename CallbackType>
-				void flush(CallbackType callback)
+				inline void releaseTransferred(std::size_t sizeTransferred)
 				{
-					if (!transferring)
+					// removing all fully transferred chunks; the reminder of a partially transferred chunk will be sent with the next write
+					while (sizeTransferred > 0 && transferBufferQueue.size())
 					{
-						while (!transferBufferQueue.empty())
+						auto& transferDataChunk = transferBufferQueue.front();
+						auto  size{transferDataChunk.segmentPtr->getSize() - transferDataChunk.offset};
+
+						if (sizeTransferred < size)
 						{
-							transferBufferQueue.pop();
+							transferDataChunk.offset += sizeTransferred;
+							break;
 						}
-						callback();
+
+						sizeTransferred -= size;
+						popTransferDataChunk();
 					}
-					else
+				}
+
+				inline void submitSegments(const EncodedSegments& segments)
+				{
+					// encoded segments are shared with other sessions so only references are queued
+					for (auto& segmentPtr : segments)
 					{
-						// waiting until data is transferred
-						timer = ts::ref(processorProxy.processWithDelay([&, callback = std::move(callback)]
+						queuedBytes += segmentPtr->getSize();
+						transferBufferQueue.push_back(TransferDataChunk{segmentPtr, 0});
+					}
+
+					if (!segments.empty())
+					{
+						processorProxy.process([&]
 						{
-							flush(std::move(callback));
-						}, std::chrono::milliseconds{1}));
+							transferTask();
+						});
 					}
 				}
 
@@ -265,19 +320,21 @@ namespace slim
 					// it will disabling submiting write async requests from any other task until this write succeeds
 					transferring = true;
 
-					auto& transferDataChunk = transferBufferQueue.front();
-					connection.get().writeAsync(transferDataChunk.buffer.getData() + transferDataChunk.offset, transferDataChunk.size - transferDataChunk.offset, [this](auto error, auto sizeTransferred)
+					// all queued chunks are submitted within one gather write instead of a write per chunk
+					auto submittedChunks{std::min(transferBufferQueue.size(), maxGatherChunks)};
+					transferringChunks = submittedChunks;
+					transferBuffers.clear();
+					for (std::size_t i = 0; i < submittedChunks; i++)
 					{
-						// using RAII guard to ensure that a buffer is removed from the queue unless it is explicitly instructed not to do so
-						auto releaseBuffer = true;
+						auto& transferDataChunk = transferBufferQueue[i];
+						transferBuffers.push_back(util::WriteBuffer{transferDataChunk.segmentPtr->getData() + transferDataChunk.offset, transferDataChunk.segmentPtr->getSize() - transferDataChunk.offset});
+					}
+
+					connection.get().writeAsync(transferBuffers, [this, submittedChunks](auto error, auto sizeTransferred, auto)
+					{
+						// reseting transferring flag and submitting a new transfer task so it can write async
 						::util::scope_guard onExit = [&]
 						{
-							if (releaseBuffer && transferBufferQueue.size())
-							{
-								transferBufferQueue.pop();
-							}
-
-							// reseting transferring flag and submitting a new transfer task so it can write async
 							transferring = false;
 							processorProxy.process([&]
 							{
@@ -285,30 +342,19 @@ namespace slim
 							});
 						};
 
-						// if case of transfer error just log the error; chunk will be removed from the queue by the RAII guard
+						// if case of transfer error just log the error and drop submitted chunks
 						if (error)
 						{
-							LOG(ERROR) << LABELS{"proto"} << "Error while transferring data chunk: " << error.message();
-							return;
-						}
+							LOG(ERROR) << LABELS{"proto"} << "Error while transferring data chunks: " << error.message();
 
-						// guarding against cases when queue has been flushed
-						if (!transferBufferQueue.size())
-						{
+							for (std::size_t i = 0; i < submittedChunks && transferBufferQueue.size(); i++)
+							{
+								popTransferDataChunk();
+							}
 							return;
 						}
 
-						auto& transferDataChunk = transferBufferQueue.front();
-						if (sizeTransferred < transferDataChunk.size - transferDataChunk.offset)
-						{
-							LOG(INFO) << LABELS{"proto"} << "Incomplete buffer content was sent, transmitting reminder: chunk size=" << transferDataChunk.size << ", transferred=" << sizeTransferred;
-
-							// setting up transfer chunk data to transfer only the reminder
-							transferDataChunk.offset += sizeTransferred;
-
-							// it will instruct the guard not to release transfer data chunk back to the pool
-							releaseBuffer = false;
-						}
+						releaseTransferred(sizeTransferred);
 					});
 				}
 
@@ -317,12 +363,22 @@ namespace slim
 				std::reference_wrapper<ConnectionType>                   connection;
 				std::reference_wrapper<StreamerType>                     streamer;
 				std::string                                              clientID;
-				std::unique_ptr<EncoderBase>                             encoderPtr;
+				std::string                                              mime;
+				unsigned int                                             samplingRate;
 				bool                                                     running{false};
+				bool                                                     stopping{false};
 				bool                                                     transferring{false};
+				std::size_t                                              transferringChunks{0};
+				std::vector<std::function<void()>>                       stopCallbacks;
+				// TODO: parameterize
+				util::Duration                                           drainTimeout{std::chrono::seconds{2}};
 				// TODO: parameterize
-				util::buffer::BufferPool<std::uint8_t>                   bufferPool{64, 4096};
-				std::queue<TransferDataChunk>                            transferBufferQueue;
+				std::size_t                                              maxQueuedBytes{64 * 4096};
+				std::size_t                                              queuedBytes{0};
+				std::deque<TransferDataChunk>                            transferBufferQueue;
+				// limit of buffers per gather write is well below IOV_MAX
+				std::size_t                                              maxGatherChunks{64};
+				util::WriteBuffers                                       transferBuffers;
 				util::BigInteger                                         framesProvided{0};
 				ts::optional_ref<conwrap2::Timer>                        timer{ts::nullopt};
 		};
@@ -62,15 +62,15 @@ namespace slim
 				public:
 					// this constructor is used in case of CommandSelection::Time, CommandSelection::Stop, etc.
 					CommandSTRM(CommandSelection commandSelection)
-					: CommandSTRM{commandSelection, FormatSelection::FLAC, 0, 0, {}} {}
+					: CommandSTRM{commandSelection, FormatSelection::FLAC, 0, 0, 0, {}} {}
 
 					CommandSTRM(CommandSelection commandSelection, util::Timestamp startAt)
-					: CommandSTRM{commandSelection, FormatSelection::FLAC, 0, 0, {}}
+					: CommandSTRM{commandSelection, FormatSelection::FLAC, 0, 0, 0, {}}
 					{
 						strm.data.replayGain = htonl(static_cast<std::uint32_t>(startAt.get(util::milliseconds)));
 					}
 
-					CommandSTRM(CommandSelection commandSelection, FormatSelection formatSelection, unsigned int port, unsigned int samplingRate, std::string clientID)
+					CommandSTRM(CommandSelection commandSelection, FormatSelection formatSelection, unsigned int bitsPerSample, unsigned int port, unsigned int samplingRate, std::string clientID)
 					{
 						memset(&strm, 0, sizeof(STRM));
 						memcpy(&strm.data.opcode, "strm", sizeof(strm.data.opcode));
@@ -82,7 +82,7 @@ namespace slim
 						if (formatSelection == FormatSelection::PCM)
 						{
 							strm.data.format       = 'p';  // PCM
-							strm.data.sampleSize   = '3';  // 32 bits per sample
+							strm.data.sampleSize   = mapBitsPerSample(bitsPerSample);
 							strm.data.samplingRate = mapSamplingRate(samplingRate);
 							strm.data.channels     = '2';  // stereo
 							strm.data.endianness   = '1';  // WAV
@@ -140,6 +140,31 @@ namespace slim
 						return size;
 					}
 
+					// this method use used only in case of WAVE transfer
+					char mapBitsPerSample(unsigned int bitsPerSample)
+					{
+						char result = '?';
+
+						if (bitsPerSample == 8)
+						{
+							result = '0';
+						}
+						else if (bitsPerSample == 16)
+						{
+							result = '1';
+						}
+						else if (bitsPerSample == 24)
+						{
+							result = '2';
+						}
+						else if (bitsPerSample == 32)
+						{
+							result = '3';
+						}
+
+						return result;
+					}
+
 					// this method use used only in case of WAVE transfer
 					char mapSamplingRate(unsigned int samplingRate)
 					{
@@ -16,13 +16,27 @@
 #include <functional>
 #include <iostream>  // std::streampos
 #include <string>
+#include <system_error>
+#include <vector>
+
+#include "slim/util/Timestamp.hpp"
 
 
 namespace slim
 {
 	namespace util
 	{
-		using WriteCallback = std::function<void(const std::error_code, const std::size_t)>;
+		// timestamp is taken when the write is completed by the thread performing it, before callback is handed over to other threads
+		using WriteCallback = std::function<void(const std::error_code, const std::size_t, const Timestamp)>;
+
+		// describes one element of a gather write; data must stay valid until the write is completed
+		struct WriteBuffer
+		{
+			const void* data;
+			std::size_t size;
+		};
+
+		using WriteBuffers = std::vector<WriteBuffer>;
 
 		class AsyncWriter
 		{
@@ -38,12 +52,34 @@ namespace slim
 
 				virtual std::size_t write(const void* data, const std::size_t size) = 0;
 
-				virtual void writeAsync(std::string str, WriteCallback callback = [](auto, auto) {})
+				virtual void writeAsync(std::string str, WriteCallback callback = [](auto, auto, auto) {})
 				{
 					writeAsync(str.c_str(), str.length(), callback);
 				}
 
-				virtual void writeAsync(const void* data, const std::size_t size, WriteCallback callback = [](auto, auto) {}) = 0;
+				virtual void writeAsync(const void* data, const std::size_t size, WriteCallback callback = [](auto, auto, auto) {}) = 0;
+
+				// callback receives total amount of bytes transferred across all buffers; writers which do not support
+				// gather writes fall back to writing buffers one by one
+				virtual void writeAsync(const WriteBuffers& buffers, WriteCallback callback = [](auto, auto, auto) {})
+				{
+					auto error{std::error_code{}};
+					auto transferred{std::size_t{0}};
+
+					for (auto& buffer : buffers)
+					{
+						auto written{write(buffer.data, buffer.size)};
+
+						transferred += written;
+						if (written < buffer.size)
+						{
+							error = std::make_error_code(std::errc::io_error);
+							break;
+						}
+					}
+
+					callback(error, transferred, Timestamp::now());
+				}
 		};
 	}
 }
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2017, Andrej Kislovskij
+ *
+ * This is PUBLIC DOMAIN software so use at your own risk as it comes
+ * with no warranties. This code is yours to share, use and modify without
+ * any restrictions or obligations.
+ *
+ * For more information see conwrap/LICENSE or refer refer to http://unlicense.org
+ *
+ * Author: gimesketvirtadieni at gmail dot com (Andrej Kislovskij)
+ */
+
+#pragma once
+
+#include <cerrno>
+#include <cstdint>  // std::u..._t types
+#include <cstring>  // std::strerror
+#include <experimental/net>
+#include <string>
+#include <sys/eventfd.h>
+#include <system_error>
+#include <unistd.h>
+
+#include "slim/Exception.hpp"
+
+
+namespace slim
+{
+	namespace util
+	{
+		// notification may be issued from a real-time thread (it does not allocate memory or lock) and it is received by an event-loop
+		class EventNotifier
+		{
+			public:
+				EventNotifier(std::experimental::net::io_context& context)
+				: nativeSocket{context}
+				{
+					auto fd{::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)};
+					if (fd < 0)
+					{
+						throw Exception(std::string{"Could not create eventfd: "} + std::strerror(errno));
+					}
+
+					// networking-ts does not provide a descriptor type, however a socket can wait for readiness of any descriptor
+					std::error_code error;
+					nativeSocket.assign(std::experimental::net::ip::tcp::v4(), fd, error);
+					if (error)
+					{
+						::close(fd);
+						throw Exception(std::string{"Could not register eventfd: "} + error.message());
+					}
+				}
+
+				// using Rule Of Zero
+				~EventNotifier() = default;
+				EventNotifier(const EventNotifier&) = delete;             // non-copyable
+				EventNotifier& operator=(const EventNotifier&) = delete;  // non-assignable
+				EventNotifier(EventNotifier&& rhs) = delete;              // non-movable
+				EventNotifier& operator=(EventNotifier&& rhs) = delete;   // non-move-assignable
+
+				inline void cancel()
+				{
+					std::error_code error;
+					nativeSocket.cancel(error);
+				}
+
+				// it is safe to call this method from any thread
+				inline void notify()
+				{
+					std::uint64_t value{1};
+
+					// if counter overflows then there is a pending notification anyway
+					[[maybe_unused]] auto result{::write(nativeSocket.native_handle(), &value, sizeof(value))};
+				}
+
+				template<typename CallbackType>
+				inline void wait(CallbackType callback)
+				{
+					nativeSocket.async_wait(std::experimental::net::socket_base::wait_read, [&, callback = std::move(callback)](const std::error_code& error)
+					{
+						// if wait was canceled then this object may not exist anymore
+						if (!error)
+						{
+							// resetting counter before callback so notifications issued while callback is running are not lost
+							std::uint64_t value;
+							[[maybe_unused]] auto result{::read(nativeSocket.native_handle(), &value, sizeof(value))};
+
+							callback();
+						}
+					});
+				}
+
+			private:
+				std::experimental::net::ip::tcp::socket nativeSocket;
+		};
+	}
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2017, Andrej Kislovskij
+ *
+ * This is PUBLIC DOMAIN software so use at your own risk as it comes
+ * with no warranties. This code is yours to share, use and modify without
+ * any restrictions or obligations.
+ *
+ * For more information see conwrap/LICENSE or refer refer to http://unlicense.org
+ *
+ * Author: gimesketvirtadieni at gmail dot com (Andrej Kislovskij)
+ */
+
+#pragma once
+
+#include <cerrno>
+#include <cstring>  // std::strerror
+#include <pthread.h>
+#include <sched.h>
+#include <string>
+#include <sys/mman.h>
+#include <vector>
+
+#include "slim/Exception.hpp"
+#include "slim/log/log.hpp"
+
+
+namespace slim
+{
+	namespace util
+	{
+		// these helpers throw an exception if a setting could not be applied, so that a caller can decide how to report it
+
+		inline void lockMemory()
+		{
+			// locking all current and future pages so that real-time threads are never stalled by paging; pages are locked only
+			// once they are touched, otherwise the whole chunk arena would be made resident even if most of it is never used
+			if (::mlockall(MCL_CURRENT | MCL_FUTURE | MCL_ONFAULT) != 0)
+			{
+				throw Exception(std::string{"Could not lock memory: "} + std::strerror(errno));
+			}
+		}
+
+		inline void setThreadAffinity(const std::vector<unsigned int>& cpus)
+		{
+			cpu_set_t cpuSet;
+
+			CPU_ZERO(&cpuSet);
+			for (auto cpu : cpus)
+			{
+				if (cpu >= CPU_SETSIZE)
+				{
+					throw Exception(std::string{"Could not set CPU affinity: invalid CPU number "} + std::to_string(cpu));
+				}
+				CPU_SET(cpu, &cpuSet);
+			}
+
+			// pthread functions return an error code instead of setting errno
+			if (auto error{::pthread_setaffinity_np(::pthread_self(), sizeof(cpuSet), &cpuSet)}; error != 0)
+			{
+				throw Exception(std::string{"Could not set CPU affinity: "} + std::strerror(error));
+			}
+		}
+
+		inline void setThreadRealTimePriority(int priority)
+		{
+			sched_param parameters{};
+
+			parameters.sched_priority = priority;
+			if (auto error{::pthread_setschedparam(::pthread_self(), SCHED_FIFO, &parameters)}; error != 0)
+			{
+				throw Exception(std::string{"Could not set real-time priority "} + std::to_string(priority) + ": " + std::strerror(error));
+			}
+		}
+
+		// settings are not mandatory for capture threads, so failures are reported and the calling thread carries on
+		inline void applyThreadSettings(int priority, const std::vector<unsigned int>& cpus)
+		{
+			if (priority > 0)
+			{
+				try
+				{
+					setThreadRealTimePriority(priority);
+				}
+				catch (const Exception& error)
+				{
+					LOG(WARNING) << LABELS{"slim"} << error;
+				}
+			}
+
+			if (!cpus.empty())
+			{
+				try
+				{
+					setThreadAffinity(cpus);
+				}
+				catch (const Exception& error)
+				{
+					LOG(WARNING) << LABELS{"slim"} << error;
+				}
+			}
+		}
+	}
+}
@@ -47,6 +47,8 @@
  *  - added <cstddef> include required for size_t type
  *  - added an initializer for buffer elements
  *  - changed API to allow using non-copyable & non-movable T
+ *  - added batch dequeue, which publishes tail once per batch
+ *  - added queue depth accessors
  */
 namespace slim
 {
@@ -112,6 +114,52 @@ namespace slim
 					}
 				}
 
+				// mover is called with a contiguous span of ready elements (twice if ready elements wrap around) and returns
+				// number of elements it consumed; tail is published once for the whole batch
+				template<typename M, typename H>
+				inline size_t dequeueBatch(size_t maxItems, const M& mover, const H& underfowHandler)
+				{
+					const size_t tail{_tail.load(std::memory_order_relaxed)};
+					const size_t available{(_head.load(std::memory_order_acquire) - tail) & _mask};
+					size_t       consumed{0};
+
+					if (available >= 1)
+					{
+						const size_t count{available < maxItems ? available : maxItems};
+						const size_t first{tail & _mask};
+						const size_t contiguous{count < _size - first ? count : _size - first};
+
+						consumed = mover(_buffer + first, contiguous);
+						if (consumed == contiguous && count > contiguous)
+						{
+							consumed += mover(_buffer, count - contiguous);
+						}
+
+						if (consumed > 0)
+						{
+							_tail.store(tail + consumed, std::memory_order_release);
+						}
+					}
+					else
+					{
+						underfowHandler();
+					}
+
+					return consumed;
+				}
+
+				// capacity is one element less than size as one element is used to distinguish between full and empty states
+				inline size_t getCapacity() const
+				{
+					return _size - 1;
+				}
+
+				// the value is approximate if called concurrently with enqueue / dequeue
+				inline size_t getReadySize() const
+				{
+					return (_head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire)) & _mask;
+				}
+
 				template<typename M, typename H>
 				inline void enqueue(const M& mover, const H& overflowHandler)
 				{
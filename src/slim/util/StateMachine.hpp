@@ -12,62 +12,127 @@
 
 #pragma once
 
-#include <algorithm>
-#include <functional>
-#include <vector>
+#include <array>
+#include <cstddef>  // std::size_t
 
 
 namespace slim
 {
 	namespace util
 	{
-		template <typename EventType, typename StateType>
+		// actions and guards are owner's member functions, so they are bound statically; nullptr means no action / no guard
+		template <typename OwnerType, typename EventType, typename StateType>
 		struct Transition
 		{
-			EventType                      event;
-			StateType                      fromState;
-			StateType                      toState;
-			std::function<void(EventType)> action;
-			std::function<bool()>          guard;
+			using ActionType = void (OwnerType::*)();
+			using GuardType  = bool (OwnerType::*)();
+
+			EventType  event;
+			StateType  fromState;
+			StateType  toState;
+			ActionType action;
+			GuardType  guard;
 		};
 
-		template <typename EventType, typename StateType>
-		struct StateMachine
+		// owner provides a transition table with a static constexpr getTransitions() method; the table is converted
+		// at compile time into a [state][event] matrix, so processing an event does not search nor allocate
+		template <typename OwnerType, typename EventType, typename StateType>
+		class StateMachine
 		{
-			StateType                                     state;
-			std::vector<Transition<EventType, StateType>> transitions;
+			using TransitionType = Transition<OwnerType, EventType, StateType>;
 
-			template <typename ErrorHandlerType>
-			bool processEvent(EventType event, ErrorHandlerType errorHandler)
+			struct Cell
 			{
-				auto result{false};
+				bool                               defined{false};
+				StateType                          toState{};
+				typename TransitionType::ActionType action{nullptr};
+				typename TransitionType::GuardType  guard{nullptr};
+			};
 
-				// searching for a transition based on the event and the current state
-				auto found = std::find_if(transitions.begin(), transitions.end(), [&](const auto& transition)
-				{
-					return (transition.fromState == state && transition.event == event);
-				});
+			template <std::size_t States, std::size_t Events>
+			using TableType = std::array<std::array<Cell, Events>, States>;
+
+			public:
+				StateMachine(OwnerType& o, StateType s)
+				: state{s}
+				, owner{o} {}
 
-				// if found then perform a transition if guard allows
-				if (found != transitions.end())
+				StateType state;
+
+				template <typename ErrorHandlerType>
+				bool processEvent(EventType event, ErrorHandlerType errorHandler)
 				{
-					// invoking transition action if guar is satisfied
-					if ((*found).guard())
+					static constexpr auto transitions{OwnerType::getTransitions()};
+					static constexpr auto table{createTable<getDimension(transitions, &TransitionType::fromState), getDimension(transitions, &TransitionType::event)>(transitions)};
+
+					auto result{false};
+
+					// looking up a transition based on the current state and the event
+					if (static_cast<std::size_t>(state) < table.size() && static_cast<std::size_t>(event) < table[state].size() && table[state][event].defined)
 					{
-						(*found).action(event);
+						auto& cell{table[state][event]};
+
+						// invoking transition action if guard is satisfied
+						if (!cell.guard || (owner.*cell.guard)())
+						{
+							if (cell.action)
+							{
+								(owner.*cell.action)();
+							}
+
+							// changing state of the state machine and reporting about successful transition
+							state  = cell.toState;
+							result = true;
+						}
+					}
+					else
+					{
+						errorHandler(event, state);
+					}
 
-						// changing state of the state machine and reporting about successful transition
-						state  = (*found).toState;
-						result = true;
+					return result;
+				}
+
+			protected:
+				template <std::size_t States, std::size_t Events, typename TransitionsType>
+				static constexpr auto createTable(const TransitionsType& transitions)
+				{
+					TableType<States, Events> table{};
+
+					// the first transition defined for a state / event pair wins
+					for (auto& transition : transitions)
+					{
+						auto& cell{table[transition.fromState][transition.event]};
+						if (!cell.defined)
+						{
+							cell.defined = true;
+							cell.toState = transition.toState;
+							cell.action  = transition.action;
+							cell.guard   = transition.guard;
+						}
 					}
+
+					return table;
 				}
-				else
+
+				template <typename TransitionsType, typename FieldType>
+				static constexpr std::size_t getDimension(const TransitionsType& transitions, FieldType TransitionType::* field)
 				{
-					errorHandler(event, state);
+					std::size_t result{0};
+
+					for (auto& transition : transitions)
+					{
+						if (result <= static_cast<std::size_t>(transition.*field))
+						{
+							result = static_cast<std::size_t>(transition.*field) + 1;
+						}
+					}
+
+					return result;
 				}
 
-				return result;
-			}
+			private:
+				OwnerType& owner;
 		};
 	}
 }
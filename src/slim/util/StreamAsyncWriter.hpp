@@ -66,17 +66,17 @@ namespace slim
 				// including writeAsync overloads
 				using AsyncWriter::writeAsync;
 
-				virtual void writeAsync(const void* data, const std::size_t size, WriteCallback callback = [](auto, auto) {}) override
+				virtual void writeAsync(const void* data, const std::size_t size, WriteCallback callback = [](auto, auto, auto) {}) override
 				{
 					try
 					{
 						write(data, size);
-						callback(std::error_code(), size);
+						callback(std::error_code(), size, Timestamp::now());
 					}
 					catch(const std::exception& error)
 					{
 						LOG(ERROR) << error.what();
-						callback(std::make_error_code(std::errc::io_error), 0);
+						callback(std::make_error_code(std::errc::io_error), 0, Timestamp::now());
 					}
 				}
 
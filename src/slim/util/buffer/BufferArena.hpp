@@ -0,0 +1,146 @@
+/*
+ * Copyright 2017, Andrej Kislovskij
+ *
+ * This is PUBLIC DOMAIN software so use at your own risk as it comes
+ * with no warranties. This code is yours to share, use and modify without
+ * any restrictions or obligations.
+ *
+ * For more information see conwrap/LICENSE or refer refer to http://unlicense.org
+ *
+ * Author: gimesketvirtadieni at gmail dot com (Andrej Kislovskij)
+ */
+
+#pragma once
+
+#include <cstddef>  // std::size_t
+#include <cstdint>  // std::u..._t types
+#include <memory>
+#include <utility>  // std::move
+
+#include "slim/util/buffer/FreeList.hpp"
+#include "slim/util/buffer/HeapBuffer.hpp"
+
+
+namespace slim
+{
+namespace util
+{
+namespace buffer
+{
+
+template
+<
+    typename ElementType
+>
+class BufferArena;
+
+template
+<
+    typename ElementType
+>
+class ArenaBufferStorage
+{
+    public:
+        // deleter returns a buffer back to the arena instead of freeing memory
+        struct Releaser
+        {
+            inline void operator()(ElementType*) const
+            {
+                arenaPtr->release(index);
+            }
+
+            BufferArena<ElementType>* arenaPtr{nullptr};
+            FreeList::IndexType       index{0};
+        };
+
+        using PointerType = std::unique_ptr<ElementType[], Releaser>;
+        using SizeType    = std::size_t;
+
+        inline explicit ArenaBufferStorage(PointerType d, const SizeType& s)
+        : data{std::move(d)}
+        , size{s} {}
+
+        inline ArenaBufferStorage(const SizeType& s = 0)
+        : data{}
+        , size{s} {}
+
+        PointerType data;
+        SizeType    size;
+};
+
+/*
+ * Fixed-size buffers carved out of one memory block, which is not initialized so its pages become
+ * resident only once a buffer is written to. Free buffers are tracked outside of the block and
+ * released buffers are reused in LIFO order so that recently touched memory is preferred.
+ * Allocating and releasing is lock-free (no system calls, no memory allocation), which makes it
+ * suitable for real-time threads.
+ */
+template
+<
+    typename ElementType
+>
+class BufferArena
+{
+    public:
+        using SizeType        = std::size_t;
+        using ArenaBufferType = HeapBuffer<ElementType, ArenaBufferStorage>;
+
+        inline explicit BufferArena(const SizeType& poolSize, const SizeType& bs)
+        : bufferSize{bs}
+        , dataPtr{new ElementType[poolSize * bs]}
+        , freeList{poolSize} {}
+
+        // arena is referenced by allocated buffers so it must not be moved
+        ~BufferArena() = default;
+        BufferArena(const BufferArena&) = delete;             // non-copyable
+        BufferArena& operator=(const BufferArena&) = delete;  // non-assignable
+        BufferArena(BufferArena&& rhs) = delete;              // non-movable
+        BufferArena& operator=(BufferArena&& rhs) = delete;   // non-move-assignable
+
+        inline auto allocate()
+        {
+            auto index{freeList.pop()};
+
+            // if no available buffer was found
+            if (index == FreeList::emptyIndex)
+            {
+                return ArenaBufferType{ArenaBufferStorage<ElementType>{}};
+            }
+
+            auto bufferProxyPtr = typename ArenaBufferStorage<ElementType>::PointerType{dataPtr.get() + index * bufferSize, {this, index}};
+
+            return ArenaBufferType{ArenaBufferStorage<ElementType>{std::move(bufferProxyPtr), bufferSize}};
+        }
+
+        inline const auto getAvailableSize() const
+        {
+            return freeList.getAvailableSize();
+        }
+
+        inline const auto getBufferSize() const
+        {
+            return bufferSize;
+        }
+
+        inline const auto getSize() const
+        {
+            return freeList.getSize();
+        }
+
+    protected:
+        friend typename ArenaBufferStorage<ElementType>::Releaser;
+
+        inline void release(const FreeList::IndexType& index)
+        {
+            freeList.push(index);
+        }
+
+    private:
+        SizeType                       bufferSize;
+        std::unique_ptr<ElementType[]> dataPtr;
+        FreeList                       freeList;
+};
+
+}
+}
+}
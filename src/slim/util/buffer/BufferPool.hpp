@@ -12,10 +12,11 @@
 
 #pragma once
 
-#include <algorithm>
+#include <cstddef>  // std::size_t
 #include <memory>
-#include <vector>
+#include <new>      // __STDCPP_DEFAULT_NEW_ALIGNMENT__
 
+#include "slim/util/buffer/FreeList.hpp"
 #include "slim/util/buffer/HeapBuffer.hpp"
 
 
@@ -26,6 +27,47 @@ namespace util
 namespace buffer
 {
 
+// every pooled buffer is preceded by a header, which allows a stateless deleter to find where to return the buffer
+struct PooledBufferHeader
+{
+    template
+    <
+        typename ElementType
+    >
+    static constexpr std::size_t getSize()
+    {
+        // header is padded so that buffer data following the header is properly aligned
+        constexpr auto alignment{alignof(ElementType) > alignof(PooledBufferHeader) ? alignof(ElementType) : alignof(PooledBufferHeader)};
+
+        return ((sizeof(PooledBufferHeader) + alignment - 1) / alignment) * alignment;
+    }
+
+    template
+    <
+        typename ElementType
+    >
+    inline static auto* fromData(ElementType* data)
+    {
+        return reinterpret_cast<PooledBufferHeader*>(reinterpret_cast<unsigned char*>(data) - getSize<ElementType>());
+    }
+
+    FreeList*           freeListPtr;
+    FreeList::IndexType index;
+};
+
+template
+<
+    typename ElementType
+>
+struct PooledBufferReleaser
+{
+    inline void operator()(ElementType* data) const
+    {
+        auto* headerPtr{PooledBufferHeader::fromData(data)};
+        headerPtr->freeListPtr->push(headerPtr->index);
+    }
+};
+
 template
 <
     typename ElementType
@@ -33,7 +75,7 @@ template
 class PooledBufferStorage
 {
     public:
-        using PointerType = std::unique_ptr<ElementType[], std::function<void(ElementType*)>>;
+        using PointerType = std::unique_ptr<ElementType[], PooledBufferReleaser<ElementType>>;
         using SizeType    = std::size_t;
 
         inline explicit PooledBufferStorage(PointerType d, const SizeType& s)
@@ -48,6 +90,12 @@ class PooledBufferStorage
         SizeType    size;
 };
 
+/*
+ * Allocating and releasing a buffer takes constant time and it is lock-free, so buffers may be released
+ * from a thread different from the one that allocated them.
+ *
+ * Capture chunks are allocated from Chunk::ArenaType instead, so the pool is not used by the streamer itself.
+ */
 template
 <
     typename ElementType,
@@ -60,83 +108,82 @@ class BufferPool
         using PooledBufferType = BufferType<ElementType, PooledBufferStorage>;
 
         inline explicit BufferPool(const SizeType& poolSize, const SizeType& bufferSize)
-        : bufferWrappersPtr{std::make_unique<std::vector<BufferWrapper>>()}
-        {
-            for (SizeType i = 0; i < poolSize; i++)
-            {
-                bufferWrappersPtr->emplace_back(BufferWrapper{BufferType{DefaultHeapBufferStorage<ElementType>{bufferSize}}, true});
-            }
-        }
+        : poolPtr{std::make_unique<Pool>(poolSize, bufferSize)} {}
 
         inline auto allocate()
         {
-            // no need to guard here against cases when pool 'was moved from' this object as getSize() will return 0
-            for (SizeType i = 0; i < getSize(); i++)
+            // guarding against cases when BufferPool content was moved to a different object
+            if (!poolPtr)
             {
-                auto& bufferWrapper = getBufferWrappers()[i];
-                if (bufferWrapper.free)
-                {
-                    // creating a 'proxy' object, which wraps an existing buffer and will release it back to the pool upon destruction
-                    auto bufferProxyPtr = typename PooledBufferStorage<ElementType>::PointerType{bufferWrapper.buffer.getData(), [&bufferWrappers = getBufferWrappers(), index = i](auto* data)
-                    {
-                        bufferWrappers[index].free = true;
-                    }};
-                    auto pooledBufferStorage = PooledBufferStorage<ElementType>{std::move(bufferProxyPtr), bufferWrapper.buffer.getSize()};
+                return PooledBufferType{PooledBufferStorage<ElementType>{}};
+            }
 
-                    // marking this buffer as used
-                    bufferWrapper.free = false;
+            auto index{poolPtr->freeList.pop()};
 
-                    return PooledBufferType{std::move(pooledBufferStorage)};
-                }
+            // this point is reached if no available buffer was found
+            if (index == FreeList::emptyIndex)
+            {
+                return PooledBufferType{PooledBufferStorage<ElementType>{}};
             }
 
-            // this point is reached if no available buffer was found
-            return PooledBufferType{PooledBufferStorage<ElementType>{}};
+            return PooledBufferType{PooledBufferStorage<ElementType>{typename PooledBufferStorage<ElementType>::PointerType{poolPtr->getData(index)}, poolPtr->bufferSize}};
         }
 
         inline const auto getAvailableSize() const
         {
             // guarding against cases when BufferPool content was moved to a different object
-            if (!bufferWrappersPtr)
-            {
-                return std::size_t{0};
-            }
-
-            // auto may not be used here as count_if returns signed value
-            SizeType s = std::count_if(bufferWrappersPtr->begin(), bufferWrappersPtr->end(), [](const auto& bufferWrapper)
-            {
-                return bufferWrapper.free;
-            });
-
-            return s;
+            return poolPtr ? poolPtr->freeList.getAvailableSize() : std::size_t{0};
         }
 
         inline const auto getSize() const
         {
             // guarding against cases when BufferPool content was moved to a different object
-            if (!bufferWrappersPtr)
-            {
-                return std::size_t{0};
-            }
-
-            return bufferWrappersPtr->size();
+            return poolPtr ? poolPtr->freeList.getSize() : std::size_t{0};
         }
 
     protected:
-        struct BufferWrapper
-        {
-            BufferType<ElementType, DefaultHeapBufferStorage> buffer;
-            bool                                              free;
-        };
+        static_assert(alignof(ElementType) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "Over-aligned types are not supported");
 
-        inline auto& getBufferWrappers()
+        // all buffers are allocated within one memory block where each buffer is preceded by its header
+        struct Pool
         {
-            return *bufferWrappersPtr.get();
-        }
+            inline Pool(const SizeType& poolSize, const SizeType& bs)
+            : bufferSize{bs}
+            , blockSize{PooledBufferHeader::getSize<ElementType>() + ((bs * sizeof(ElementType) + headerAlignment - 1) / headerAlignment) * headerAlignment}
+            , memoryPtr{new unsigned char[poolSize * blockSize]}
+            , freeList{poolSize}
+            {
+                for (SizeType i = 0; i < poolSize; i++)
+                {
+                    new (memoryPtr.get() + i * blockSize) PooledBufferHeader{&freeList, static_cast<FreeList::IndexType>(i)};
+                    std::uninitialized_default_construct_n(getData(i), bufferSize);
+                }
+            }
+
+            inline ~Pool()
+            {
+                for (SizeType i = 0; i < freeList.getSize(); i++)
+                {
+                    std::destroy_n(getData(i), bufferSize);
+                }
+            }
+
+            inline ElementType* getData(const SizeType& index)
+            {
+                return reinterpret_cast<ElementType*>(memoryPtr.get() + index * blockSize + PooledBufferHeader::getSize<ElementType>());
+            }
+
+            static constexpr SizeType headerAlignment{alignof(PooledBufferHeader)};
+
+            SizeType                         bufferSize;
+            SizeType                         blockSize;
+            std::unique_ptr<unsigned char[]> memoryPtr;
+            FreeList                         freeList;
+        };
 
     private:
         // using std::unique_ptr<...> to make this pool movable
-        std::unique_ptr<std::vector<BufferWrapper>> bufferWrappersPtr;
+        std::unique_ptr<Pool> poolPtr;
 };
 
 }
@@ -0,0 +1,129 @@
+/*
+ * Copyright 2017, Andrej Kislovskij
+ *
+ * This is PUBLIC DOMAIN software so use at your own risk as it comes
+ * with no warranties. This code is yours to share, use and modify without
+ * any restrictions or obligations.
+ *
+ * For more information see conwrap/LICENSE or refer refer to http://unlicense.org
+ *
+ * Author: gimesketvirtadieni at gmail dot com (Andrej Kislovskij)
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>  // std::size_t
+#include <cstdint>  // std::u..._t types
+#include <memory>
+
+
+namespace slim
+{
+namespace util
+{
+namespace buffer
+{
+
+/*
+ * Lock-free LIFO stack of free indices (Treiber stack), which is used by pools to track available buffers.
+ * Push and pop may be called concurrently from any threads; neither of them allocates memory or blocks.
+ */
+class FreeList
+{
+    public:
+        using IndexType = std::uint32_t;
+        using SizeType  = std::size_t;
+
+        static constexpr IndexType emptyIndex{~IndexType{0}};
+
+        inline explicit FreeList(const SizeType& s)
+        : size{s}
+        , nextPtr{new std::atomic<IndexType>[s]}
+        , availableSize{s}
+        {
+            // chaining all indices; the first index is on top
+            for (SizeType i = 0; i < size; i++)
+            {
+                nextPtr[i].store(static_cast<IndexType>(i + 1 < size ? i + 1 : emptyIndex), std::memory_order_relaxed);
+            }
+            top.store(pack(size ? 0 : emptyIndex, 0), std::memory_order_release);
+        }
+
+        // using Rule Of Zero
+        ~FreeList() = default;
+        FreeList(const FreeList&) = delete;             // non-copyable
+        FreeList& operator=(const FreeList&) = delete;  // non-assignable
+        FreeList(FreeList&& rhs) = delete;              // non-movable
+        FreeList& operator=(FreeList&& rhs) = delete;   // non-move-assignable
+
+        inline const auto getAvailableSize() const
+        {
+            return availableSize.load(std::memory_order_relaxed);
+        }
+
+        inline const auto getSize() const
+        {
+            return size;
+        }
+
+        // returns emptyIndex if there are no free indices
+        inline IndexType pop()
+        {
+            auto head{top.load(std::memory_order_acquire)};
+
+            while (getIndex(head) != emptyIndex)
+            {
+                // tag is increased on every change of the top so a stale 'next' value will fail compare-exchange (ABA problem)
+                auto index{getIndex(head)};
+                if (top.compare_exchange_weak(head, pack(nextPtr[index].load(std::memory_order_relaxed), getTag(head) + 1), std::memory_order_acq_rel, std::memory_order_acquire))
+                {
+                    availableSize.fetch_sub(1, std::memory_order_relaxed);
+                    return index;
+                }
+            }
+
+            return emptyIndex;
+        }
+
+        inline void push(const IndexType& index)
+        {
+            auto head{top.load(std::memory_order_relaxed)};
+
+            do
+            {
+                nextPtr[index].store(getIndex(head), std::memory_order_relaxed);
+            }
+            while (!top.compare_exchange_weak(head, pack(index, getTag(head) + 1), std::memory_order_release, std::memory_order_relaxed));
+
+            availableSize.fetch_add(1, std::memory_order_relaxed);
+        }
+
+    protected:
+        using TopType = std::uint64_t;
+
+        inline static IndexType getIndex(const TopType& value)
+        {
+            return static_cast<IndexType>(value);
+        }
+
+        inline static IndexType getTag(const TopType& value)
+        {
+            return static_cast<IndexType>(value >> 32);
+        }
+
+        inline static TopType pack(const IndexType& index, const IndexType& tag)
+        {
+            return (static_cast<TopType>(tag) << 32) | index;
+        }
+
+    private:
+        SizeType                                  size;
+        std::unique_ptr<std::atomic<IndexType>[]> nextPtr;
+        std::atomic<TopType>                      top{0};
+        std::atomic<SizeType>                     availableSize;
+};
+
+}
+}
+}
@@ -12,8 +12,10 @@
 
 #pragma once
 
-#include <cstddef>  // std::size_t
-#include <memory>   // std::unique_ptr
+#include <cstddef>      // std::size_t
+#include <memory>       // std::unique_ptr
+#include <new>          // std::align_val_t
+#include <type_traits>  // std::is_trivial
 
 namespace slim
 {
@@ -40,6 +42,37 @@ class DefaultHeapBufferStorage
         SizeType    size;
 };
 
+// storage for buffers processed by vectorized kernels; data is aligned to the widest vector register (AVX2)
+template
+<
+    typename ElementType
+>
+class AlignedHeapBufferStorage
+{
+    static_assert(std::is_trivial<ElementType>::value, "Aligned storage does not construct elements");
+
+    public:
+        static constexpr std::size_t alignment{32};
+
+        struct Deleter
+        {
+            inline void operator()(ElementType* data) const
+            {
+                ::operator delete[](data, std::align_val_t{alignment});
+            }
+        };
+
+        using PointerType = std::unique_ptr<ElementType[], Deleter>;
+        using SizeType    = std::size_t;
+
+        inline explicit AlignedHeapBufferStorage(const SizeType& s)
+        : data{static_cast<ElementType*>(::operator new[](s * sizeof(ElementType), std::align_val_t{alignment}))}
+        , size{s} {}
+
+        PointerType data;
+        SizeType    size;
+};
+
 template
 <
     typename ElementType,
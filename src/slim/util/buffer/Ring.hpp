@@ -12,7 +12,8 @@
 
 #pragma once
 
-#include <utility>  // std::as_const
+#include <algorithm>  // std::copy_n, std::min
+#include <utility>    // std::as_const
 
 #include "slim/util/buffer/Array.hpp"
 
@@ -53,6 +54,21 @@ class DefaultRingViewPolicy : protected DefaultArrayViewPolicy<ElementType, Stor
             size = 0;
         }
 
+        // copies elements starting from offset; at most two contiguous copies are done if data wraps around
+        inline void copy(const IndexType& offset, ElementType* items, const SizeType& count) const
+        {
+            if (!count)
+            {
+                return;
+            }
+
+            auto start{normalizeIndex(head + offset)};
+            auto first{std::min<SizeType>(count, getCapacity() - start)};
+
+            std::copy_n(&DefaultArrayViewPolicy<ElementType, StorageType>::operator[](start), first, items);
+            std::copy_n(&DefaultArrayViewPolicy<ElementType, StorageType>::operator[](0), count - first, items + first);
+        }
+
         inline const auto getCapacity() const
         {
             return DefaultArrayViewPolicy<ElementType, StorageType>::getSize();
@@ -84,6 +100,14 @@ class DefaultRingViewPolicy : protected DefaultArrayViewPolicy<ElementType, Stor
             head = normalizeIndex(++head);
         }
 
+        inline void pop(const SizeType& count)
+        {
+            auto popped{std::min(count, size)};
+
+            size -= popped;
+            head  = normalizeIndex(head + popped);
+        }
+
         inline void push(const ElementType& item)
         {
             if (isFull())
@@ -102,6 +126,31 @@ class DefaultRingViewPolicy : protected DefaultArrayViewPolicy<ElementType, Stor
             DefaultArrayViewPolicy<ElementType, StorageType>::operator[](normalizeIndex(head + size - 1)) = item;
         }
 
+        // same as pushing items one by one (the oldest items are overwritten) but done with at most two contiguous copies
+        inline void push(const ElementType* items, const SizeType& count)
+        {
+            auto capacity{getCapacity()};
+            if (!capacity)
+            {
+                return;
+            }
+
+            // only the last 'capacity' items would survive
+            auto skipped{count > capacity ? count - capacity : 0};
+            auto pushed{count - skipped};
+            auto overwritten{size + pushed > capacity ? size + pushed - capacity : 0};
+
+            head  = normalizeIndex(head + overwritten);
+            size -= overwritten;
+
+            auto tail{normalizeIndex(head + size)};
+            auto first{std::min<SizeType>(pushed, capacity - tail)};
+
+            std::copy_n(items + skipped, first, &DefaultArrayViewPolicy<ElementType, StorageType>::operator[](tail));
+            std::copy_n(items + skipped + first, pushed - first, &DefaultArrayViewPolicy<ElementType, StorageType>::operator[](0));
+            size += pushed;
+        }
+
     protected:
         inline const auto getAbsoluteIndex(const IndexType& i) const
         {
@@ -16,6 +16,9 @@
 #include <string>
 
 #include "slim/EncoderBase.hpp"
+#include "slim/log/log.hpp"
+#include "slim/util/buffer/HeapBuffer.hpp"
+#include "slim/wave/Kernels.hpp"
 
 
 namespace slim
@@ -26,7 +29,8 @@ namespace slim
 		{
 			public:
 				explicit Encoder(unsigned int ch, unsigned int bs, unsigned int bv, unsigned int sr, bool hd, std::string ex, std::string mm, EncodedCallbackType ec)
-				: EncoderBase{ch, bs, bv, sr, ex, mm, ec} {}
+				: EncoderBase{ch, bs, bv, sr, ex, mm, ec}
+				, packedBitsPerSample{bs} {}
 
 				virtual ~Encoder() = default;
 				Encoder(const Encoder&) = delete;             // non-copyable
@@ -38,17 +42,59 @@ namespace slim
 				{
 					if (running)
 					{
-						getEncodedCallback()(data, size);
+						if (packedBitsPerSample == getBitsPerSample())
+						{
+							getEncodedCallback()(data, size);
+						}
+						else
+						{
+							auto samples{size / (getBitsPerSample() >> 3)};
+							auto packedSize{samples * (packedBitsPerSample >> 3)};
+
+							// scratch buffer is reused by all chunks; it is reallocated only if a chunk is larger than any previous one
+							if (scratchBuffer.getSize() < packedSize)
+							{
+								scratchBuffer = util::buffer::HeapBuffer<unsigned char>{packedSize};
+							}
+
+							if (packedBitsPerSample == 24)
+							{
+								kernels::packSamples24(data, scratchBuffer.getData(), samples);
+							}
+							else
+							{
+								kernels::packSamples16(data, scratchBuffer.getData(), samples);
+							}
+
+							getEncodedCallback()(scratchBuffer.getData(), packedSize);
+						}
 					}
 				}
 
+				// PCM values are packed to the smallest container, which fits them; values with more than 24 bits are scaled to 24 bits
+				inline static unsigned int getPackedBitsPerSample(unsigned int bitsPerValue)
+				{
+					return bitsPerValue <= 16 ? 16 : 24;
+				}
+
 				virtual bool isRunning() override
 				{
 					return running;
 				}
 
+				// packing is applicable to S32_LE input only, which is the format provided by the capture chain
+				inline void setPacked(bool packed)
+				{
+					packedBitsPerSample = (packed && getBitsPerSample() == 32 ? getPackedBitsPerSample(getBitsPerValue()) : getBitsPerSample());
+				}
+
 				virtual void start() override
 				{
+					if (getBitsPerValue() > packedBitsPerSample)
+					{
+						LOG(WARNING) << LABELS{"wave"} << "PCM data will be scaled to " << packedBitsPerSample << " bits values";
+					}
+
 					running = true;
 				}
 
@@ -61,7 +107,9 @@ namespace slim
 				}
 
 			private:
-				bool running{false};
+				bool                                    running{false};
+				unsigned int                            packedBitsPerSample;
+				util::buffer::HeapBuffer<unsigned char> scratchBuffer;
 		};
 	}
 }
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2017, Andrej Kislovskij
+ *
+ * This is PUBLIC DOMAIN software so use at your own risk as it comes
+ * with no warranties. This code is yours to share, use and modify without
+ * any restrictions or obligations.
+ *
+ * For more information see conwrap/LICENSE or refer refer to http://unlicense.org
+ *
+ * Author: gimesketvirtadieni at gmail dot com (Andrej Kislovskij)
+ */
+
+#pragma once
+
+#include <cstddef>  // std::size_t
+#include <cstdint>  // std::u..._t types
+#include <cstring>  // std::memcpy
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+namespace slim
+{
+	namespace wave
+	{
+		namespace kernels
+		{
+			// packs S32_LE samples to S24_3LE by dropping the least significant byte of every sample
+			inline void packSamples24Scalar(const unsigned char* srcBuffer, unsigned char* dstBuffer, std::size_t samples)
+			{
+				for (std::size_t i = 0; i < samples; i++)
+				{
+					dstBuffer[i * 3]     = srcBuffer[i * 4 + 1];
+					dstBuffer[i * 3 + 1] = srcBuffer[i * 4 + 2];
+					dstBuffer[i * 3 + 2] = srcBuffer[i * 4 + 3];
+				}
+			}
+
+			// packs S32_LE samples to S16_LE by dropping two least significant bytes of every sample
+			inline void packSamples16Scalar(const unsigned char* srcBuffer, unsigned char* dstBuffer, std::size_t samples)
+			{
+				for (std::size_t i = 0; i < samples; i++)
+				{
+					dstBuffer[i * 2]     = srcBuffer[i * 4 + 2];
+					dstBuffer[i * 2 + 1] = srcBuffer[i * 4 + 3];
+				}
+			}
+
+			// the same as packSamples24Scalar
+			inline void packSamples24(const unsigned char* srcBuffer, unsigned char* dstBuffer, std::size_t samples)
+			{
+				auto i{std::size_t{0}};
+
+#if defined(__SSSE3__)
+				auto mask{_mm_setr_epi8(1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15, -1, -1, -1, -1)};
+
+				for (; i + 4 <= samples; i += 4)
+				{
+					auto packed{_mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(srcBuffer + i * 4)), mask)};
+					auto tail{_mm_cvtsi128_si32(_mm_srli_si128(packed, 8))};
+
+					// storing exactly 12 bytes so that nothing is written past the end of the destination buffer
+					_mm_storel_epi64(reinterpret_cast<__m128i*>(dstBuffer + i * 3), packed);
+					std::memcpy(dstBuffer + i * 3 + 8, &tail, sizeof(tail));
+				}
+#endif
+
+				// processing samples which do not fit into a vector
+				packSamples24Scalar(srcBuffer + i * 4, dstBuffer + i * 3, samples - i);
+			}
+
+			// the same as packSamples16Scalar
+			inline void packSamples16(const unsigned char* srcBuffer, unsigned char* dstBuffer, std::size_t samples)
+			{
+				auto i{std::size_t{0}};
+
+#if defined(__SSSE3__) || defined(__SSE2__)
+				for (; i + 8 <= samples; i += 8)
+				{
+					// arithmetic shift keeps values within 16 bits so saturating pack does not alter them
+					auto x0{_mm_srai_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(srcBuffer + i * 4)), 16)};
+					auto x1{_mm_srai_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(srcBuffer + i * 4 + 16)), 16)};
+
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(dstBuffer + i * 2), _mm_packs_epi32(x0, x1));
+				}
+#endif
+
+				// processing samples which do not fit into a vector
+				packSamples16Scalar(srcBuffer + i * 4, dstBuffer + i * 2, samples - i);
+			}
+		}
+	}
+}
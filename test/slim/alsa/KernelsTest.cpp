@@ -0,0 +1,185 @@
+/*
+ * Copyright 2017, Andrej Kislovskij
+ *
+ * This is PUBLIC DOMAIN software so use at your own risk as it comes
+ * with no warranties. This code is yours to share, use and modify without
+ * any restrictions or obligations.
+ *
+ * For more information see conwrap/LICENSE or refer refer to http://unlicense.org
+ *
+ * Author: gimesketvirtadieni at gmail dot com (Andrej Kislovskij)
+ */
+
+#include <cstddef>  // std::size_t
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+#include "slim/alsa/Kernels.hpp"
+#include "slim/alsa/StreamMarker.hpp"
+
+
+namespace
+{
+	using slim::alsa::StreamMarker;
+
+	constexpr std::size_t bytesPerSample{4};
+	constexpr std::size_t bytesPerFrame{3 * bytesPerSample};
+
+	// generates S32_LE frames with two channels of random PCM data and a marker channel
+	auto createFrames(const std::vector<unsigned char>& markers)
+	{
+		std::mt19937                                generator{markers.size()};
+		std::uniform_int_distribution<unsigned int> distribution{0, 255};
+		std::vector<unsigned char>                  frames(markers.size() * bytesPerFrame);
+
+		for (std::size_t i = 0; i < frames.size(); i++)
+		{
+			// PCM data may contain the same values as markers, which is a good test for vectorized kernels
+			frames[i] = static_cast<unsigned char>(distribution(generator) & 3);
+		}
+		for (std::size_t i = 0; i < markers.size(); i++)
+		{
+			frames[(i + 1) * bytesPerFrame - 1] = markers[i];
+		}
+
+		return frames;
+	}
+
+	auto createMarkers(std::size_t size, std::size_t transitionAt, StreamMarker before, StreamMarker transition, StreamMarker after)
+	{
+		std::vector<unsigned char> markers(size, static_cast<unsigned char>(before));
+
+		for (std::size_t i = transitionAt; i < size; i++)
+		{
+			markers[i] = static_cast<unsigned char>(i == transitionAt ? transition : after);
+		}
+
+		return markers;
+	}
+
+	void validateKernels(const std::vector<unsigned char>& markers, bool producing)
+	{
+		auto frames{createFrames(markers)};
+
+		// validating find data kernel against the scalar implementation
+		auto producingScalar{producing};
+		auto producingVector{producing};
+		auto offsetScalar{slim::alsa::kernels::findDataScalar(frames.data(), markers.size(), bytesPerFrame, producingScalar)};
+		auto offsetVector{slim::alsa::kernels::findData(frames.data(), markers.size(), bytesPerFrame, bytesPerSample, producingVector)};
+
+		EXPECT_EQ(offsetScalar, offsetVector);
+		EXPECT_EQ(producingScalar, producingVector);
+
+		// validating strip marker kernel against the scalar implementation
+		std::vector<unsigned char> bufferScalar(markers.size() * (bytesPerFrame - bytesPerSample), 0);
+		std::vector<unsigned char> bufferVector(markers.size() * (bytesPerFrame - bytesPerSample), 0);
+		producingScalar = producing;
+		producingVector = producing;
+		auto framesScalar{slim::alsa::kernels::stripMarkerScalar(frames.data(), bufferScalar.data(), markers.size(), bytesPerFrame, bytesPerSample, producingScalar)};
+		auto framesVector{slim::alsa::kernels::stripMarker(frames.data(), bufferVector.data(), markers.size(), bytesPerFrame, bytesPerSample, producingVector)};
+
+		EXPECT_EQ(framesScalar, framesVector);
+		EXPECT_EQ(producingScalar, producingVector);
+		EXPECT_EQ(bufferScalar, bufferVector);
+	}
+}
+
+
+TEST(Kernels, BeginningOfStream1)
+{
+	for (std::size_t size = 1; size < 40; size++)
+	{
+		for (std::size_t transitionAt = 0; transitionAt < size; transitionAt++)
+		{
+			validateKernels(createMarkers(size, transitionAt, StreamMarker::endOfStream, StreamMarker::beginningOfStream, StreamMarker::data), false);
+		}
+	}
+}
+
+TEST(Kernels, BeginningOfStream2)
+{
+	// data markers outside of an active stream must be ignored
+	auto markers{createMarkers(37, 21, StreamMarker::data, StreamMarker::beginningOfStream, StreamMarker::data)};
+	auto frames{createFrames(markers)};
+	auto producing{false};
+
+	EXPECT_EQ(slim::alsa::kernels::findData(frames.data(), markers.size(), bytesPerFrame, bytesPerSample, producing), 22);
+	EXPECT_TRUE(producing);
+
+	validateKernels(markers, false);
+}
+
+TEST(Kernels, EndOfStream1)
+{
+	for (std::size_t size = 1; size < 40; size++)
+	{
+		for (std::size_t transitionAt = 0; transitionAt < size; transitionAt++)
+		{
+			validateKernels(createMarkers(size, transitionAt, StreamMarker::data, StreamMarker::endOfStream, StreamMarker::data), true);
+		}
+	}
+}
+
+TEST(Kernels, EndOfStream2)
+{
+	auto markers{createMarkers(37, 10, StreamMarker::data, StreamMarker::endOfStream, StreamMarker::data)};
+	auto frames{createFrames(markers)};
+	std::vector<unsigned char> buffer(markers.size() * (bytesPerFrame - bytesPerSample), 0);
+	auto producing{true};
+
+	EXPECT_EQ(slim::alsa::kernels::stripMarker(frames.data(), buffer.data(), markers.size(), bytesPerFrame, bytesPerSample, producing), 10u);
+	EXPECT_FALSE(producing);
+}
+
+TEST(Kernels, Data1)
+{
+	for (std::size_t size = 1; size < 40; size++)
+	{
+		for (std::size_t transitionAt = 0; transitionAt < size; transitionAt++)
+		{
+			validateKernels(createMarkers(size, transitionAt, StreamMarker::beginningOfStream, StreamMarker::data, StreamMarker::data), false);
+			validateKernels(createMarkers(size, transitionAt, StreamMarker::endOfStream, StreamMarker::data, StreamMarker::endOfStream), true);
+		}
+	}
+}
+
+TEST(Kernels, Data2)
+{
+	auto markers{createMarkers(64, 0, StreamMarker::data, StreamMarker::data, StreamMarker::data)};
+	auto frames{createFrames(markers)};
+	std::vector<unsigned char> buffer(markers.size() * (bytesPerFrame - bytesPerSample), 0);
+	auto producing{true};
+
+	EXPECT_EQ(slim::alsa::kernels::stripMarker(frames.data(), buffer.data(), markers.size(), bytesPerFrame, bytesPerSample, producing), 64u);
+
+	// validating that the marker channel was stripped
+	for (std::size_t i = 0; i < markers.size(); i++)
+	{
+		for (std::size_t j = 0; j < bytesPerFrame - bytesPerSample; j++)
+		{
+			EXPECT_EQ(buffer[i * (bytesPerFrame - bytesPerSample) + j], frames[i * bytesPerFrame + j]);
+		}
+	}
+}
+
+TEST(Kernels, Random1)
+{
+	std::mt19937                                generator{2017};
+	std::uniform_int_distribution<unsigned int> distribution{0, 15};
+
+	for (std::size_t size = 1; size < 200; size++)
+	{
+		std::vector<unsigned char> markers(size);
+		for (auto& marker : markers)
+		{
+			// markers are sparse so that groups consisting of data frames only are generated as well
+			auto value{distribution(generator)};
+			marker = static_cast<unsigned char>(value < 12 ? static_cast<unsigned int>(StreamMarker::data) : value & 3);
+		}
+
+		validateKernels(markers, false);
+		validateKernels(markers, true);
+	}
+}
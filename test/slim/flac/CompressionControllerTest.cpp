@@ -0,0 +1,69 @@
+/*
+ * Copyright 2017, Andrej Kislovskij
+ *
+ * This is PUBLIC DOMAIN software so use at your own risk as it comes
+ * with no warranties. This code is yours to share, use and modify without
+ * any restrictions or obligations.
+ *
+ * For more information see conwrap/LICENSE or refer refer to http://unlicense.org
+ *
+ * Author: gimesketvirtadieni at gmail dot com (Andrej Kislovskij)
+ */
+
+#include <chrono>
+#include <gtest/gtest.h>
+
+#include "slim/flac/CompressionController.hpp"
+
+
+TEST(CompressionController, Constructor1)
+{
+	slim::flac::CompressionController controller{2, 8, 50, std::chrono::seconds{5}};
+
+	EXPECT_EQ(controller.getLevel(), 2u);
+	EXPECT_EQ(controller.getStats().streams, 0u);
+}
+
+TEST(CompressionController, Update1)
+{
+	slim::flac::CompressionController controller{0, 2, 50, std::chrono::seconds{5}};
+
+	// level goes up while there is enough headroom, but never above the max level
+	controller.update(std::chrono::seconds{1}, std::chrono::seconds{10});
+	EXPECT_EQ(controller.getLevel(), 1u);
+	controller.update(std::chrono::seconds{1}, std::chrono::seconds{10});
+	EXPECT_EQ(controller.getLevel(), 2u);
+	controller.update(std::chrono::seconds{1}, std::chrono::seconds{10});
+	EXPECT_EQ(controller.getLevel(), 2u);
+
+	EXPECT_EQ(controller.getStats().load, 10u);
+	EXPECT_EQ(controller.getStats().streams, 3u);
+}
+
+TEST(CompressionController, Update2)
+{
+	slim::flac::CompressionController controller{0, 8, 50, std::chrono::seconds{5}};
+
+	controller.update(std::chrono::seconds{1}, std::chrono::seconds{10});
+	EXPECT_EQ(controller.getLevel(), 1u);
+
+	// level goes down if budget is exceeded, but never below the min level
+	controller.update(std::chrono::seconds{6}, std::chrono::seconds{10});
+	EXPECT_EQ(controller.getLevel(), 0u);
+	controller.update(std::chrono::seconds{6}, std::chrono::seconds{10});
+	EXPECT_EQ(controller.getLevel(), 0u);
+
+	// load within budget but without enough headroom keeps the level
+	controller.update(std::chrono::seconds{3}, std::chrono::seconds{10});
+	EXPECT_EQ(controller.getLevel(), 0u);
+}
+
+TEST(CompressionController, Update3)
+{
+	slim::flac::CompressionController controller{0, 8, 50, std::chrono::seconds{5}};
+
+	// short streams are ignored
+	controller.update(std::chrono::milliseconds{1}, std::chrono::seconds{1});
+	EXPECT_EQ(controller.getLevel(), 0u);
+	EXPECT_EQ(controller.getStats().streams, 0u);
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright 2017, Andrej Kislovskij
+ *
+ * This is PUBLIC DOMAIN software so use at your own risk as it comes
+ * with no warranties. This code is yours to share, use and modify without
+ * any restrictions or obligations.
+ *
+ * For more information see conwrap/LICENSE or refer refer to http://unlicense.org
+ *
+ * Author: gimesketvirtadieni at gmail dot com (Andrej Kislovskij)
+ */
+
+#include <chrono>
+#include <cstddef>  // std::size_t
+#include <cstdint>  // std::u..._t types
+#include <FLAC++/encoder.h>
+#include <gtest/gtest.h>
+#include <iostream>
+#include <vector>
+
+#include "slim/flac/Kernels.hpp"
+
+
+// benchmarks are disabled by default; use --gtest_also_run_disabled_tests --gtest_filter=*Benchmark* to run them
+namespace
+{
+	// the previous encoder approach is kept as a baseline: the least significant byte of each sample is zeroed in place
+	// and libFLAC is handed the PCM buffer shifted by one byte, so there is no copy at all
+	void zeroLowBytes(unsigned char* buffer, std::size_t samples)
+	{
+		for (std::size_t i = 0; i < samples * sizeof(std::int32_t); i += sizeof(std::int32_t))
+		{
+			buffer[i] = 0;
+		}
+	}
+
+	// encoder discards its output so that only packing and encoding is measured
+	class NullEncoder : public FLAC::Encoder::Stream
+	{
+		public:
+			NullEncoder()
+			{
+				set_verify(false);
+				set_compression_level(0);
+				set_channels(2);
+				set_sample_rate(48000);
+				set_bits_per_sample(24);
+				init();
+			}
+
+			virtual ~NullEncoder()
+			{
+				finish();
+			}
+
+		protected:
+			virtual ::FLAC__StreamEncoderWriteStatus write_callback(const FLAC__byte*, std::size_t, unsigned, unsigned) override
+			{
+				return FLAC__STREAM_ENCODER_WRITE_STATUS_OK;
+			}
+	};
+
+	template <typename FunctionType>
+	auto run(FunctionType function, std::size_t iterations)
+	{
+		auto start{std::chrono::steady_clock::now()};
+		for (std::size_t i = 0; i < iterations; i++)
+		{
+			function();
+		}
+
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+	}
+}
+
+
+TEST(FLACKernelsBenchmark, DISABLED_PackSamples)
+{
+	for (std::size_t samples : {256, 2048, 16384})
+	{
+		std::size_t                iterations{50000000 / samples};
+		std::vector<unsigned char> data(samples * sizeof(std::int32_t), 0x5A);
+		std::vector<std::int32_t>  buffer(samples, 0);
+
+		auto byteShiftTime{run([&]
+		{
+			zeroLowBytes(data.data(), samples);
+		}, iterations)};
+		auto kernelTime{run([&]
+		{
+			slim::flac::kernels::packSamples(data.data(), buffer.data(), samples, 8);
+		}, iterations)};
+
+		std::cout << "samples=" << samples
+		          << " byte-shift=" << byteShiftTime.count() << "us"
+		          << " kernel=" << kernelTime.count() << "us" << std::endl;
+
+		EXPECT_EQ(buffer[0], 0x005A5A5A);
+	}
+}
+
+
+TEST(FLACKernelsBenchmark, DISABLED_PackAndEncodeSamples)
+{
+	for (std::size_t samples : {256, 2048, 16384})
+	{
+		std::size_t                iterations{5000000 / samples};
+		// the baseline reads one byte past the last sample, so the buffer has one spare sample
+		std::vector<unsigned char> data((samples + 1) * sizeof(std::int32_t), 0x5A);
+		std::vector<std::int32_t>  buffer(samples, 0);
+		NullEncoder                byteShiftEncoder;
+		NullEncoder                kernelEncoder;
+
+		auto byteShiftTime{run([&]
+		{
+			zeroLowBytes(data.data(), samples);
+			byteShiftEncoder.process_interleaved(reinterpret_cast<const FLAC__int32*>(data.data() + 1), samples / 2);
+		}, iterations)};
+		auto kernelTime{run([&]
+		{
+			slim::flac::kernels::packSamples(data.data(), buffer.data(), samples, 8);
+			kernelEncoder.process_interleaved(buffer.data(), samples / 2);
+		}, iterations)};
+
+		std::cout << "samples=" << samples
+		          << " byte-shift+encode=" << byteShiftTime.count() << "us"
+		          << " kernel+encode=" << kernelTime.count() << "us" << std::endl;
+
+		EXPECT_EQ(buffer[0], 0x005A5A5A);
+	}
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2017, Andrej Kislovskij
+ *
+ * This is PUBLIC DOMAIN software so use at your own risk as it comes
+ * with no warranties. This code is yours to share, use and modify without
+ * any restrictions or obligations.
+ *
+ * For more information see conwrap/LICENSE or refer refer to http://unlicense.org
+ *
+ * Author: gimesketvirtadieni at gmail dot com (Andrej Kislovskij)
+ */
+
+#include <cstddef>  // std::size_t
+#include <cstdint>  // std::u..._t types
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "slim/flac/Kernels.hpp"
+#include "slim/util/SamplesHelper.hpp"
+
+
+TEST(FLACKernels, PackSamples1)
+{
+	// one extra byte is used to validate unaligned source buffers
+	for (std::size_t size = 0; size < 40; size++)
+	{
+		auto samples{createSamples(size + 1)};
+
+		for (std::size_t offset : {0, 1})
+		{
+			std::vector<std::int32_t> bufferScalar(size, 0);
+			std::vector<std::int32_t> bufferVector(size, 0);
+
+			slim::flac::kernels::packSamplesScalar(samples.data() + offset, bufferScalar.data(), size, 8);
+			slim::flac::kernels::packSamples(samples.data() + offset, bufferVector.data(), size, 8);
+
+			EXPECT_EQ(bufferScalar, bufferVector);
+		}
+	}
+}
+
+TEST(FLACKernels, PackSamples2)
+{
+	// S32_LE samples: 0x7FFFFF00, 0x80000000, 0xFFFFFF00, 0x00000100
+	std::vector<unsigned char> samples{0x00, 0xFF, 0xFF, 0x7F, 0x00, 0x00, 0x00, 0x80, 0x00, 0xFF, 0xFF, 0xFF, 0x00, 0x01, 0x00, 0x00};
+	std::vector<std::int32_t>  buffer(4, 0);
+
+	slim::flac::kernels::packSamples(samples.data(), buffer.data(), buffer.size(), 8);
+
+	// values are right-justified and sign-extended
+	EXPECT_EQ(buffer, (std::vector<std::int32_t>{8388607, -8388608, -1, 1}));
+}
+
+TEST(FLACKernels, PackSamples3)
+{
+	auto samples{createSamples(37)};
+	std::vector<std::int32_t> bufferScalar(37, 0);
+	std::vector<std::int32_t> bufferVector(37, 0);
+
+	// bits-per-value lower than 24 results in a larger shift
+	slim::flac::kernels::packSamplesScalar(samples.data(), bufferScalar.data(), 37, 16);
+	slim::flac::kernels::packSamples(samples.data(), bufferVector.data(), 37, 16);
+
+	EXPECT_EQ(bufferScalar, bufferVector);
+	for (auto value : bufferVector)
+	{
+		EXPECT_GE(value, -32768);
+		EXPECT_LE(value, 32767);
+	}
+}
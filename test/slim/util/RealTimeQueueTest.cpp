@@ -0,0 +1,176 @@
+/*
+ * Copyright 2017, Andrej Kislovskij
+ *
+ * This is PUBLIC DOMAIN software so use at your own risk as it comes
+ * with no warranties. This code is yours to share, use and modify without
+ * any restrictions or obligations.
+ *
+ * For more information see conwrap/LICENSE or refer refer to http://unlicense.org
+ *
+ * Author: gimesketvirtadieni at gmail dot com (Andrej Kislovskij)
+ */
+
+#include <cstddef>  // std::size_t
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+#include "slim/util/RealTimeQueue.hpp"
+
+
+namespace
+{
+    using QueueType = slim::util::RealTimeQueue<int>;
+
+    void enqueueValues(QueueType& queue, int from, int to)
+    {
+        for (auto i = from; i < to; i++)
+        {
+            queue.enqueue([&](int& value)
+            {
+                value = i;
+                return true;
+            }, [] {});
+        }
+    }
+}
+
+
+TEST(RealTimeQueue, DequeueBatchUnderflow1)
+{
+    QueueType queue{8};
+    auto underflow = false;
+    auto calls = 0;
+
+    auto consumed = queue.dequeueBatch(4, [&](int*, std::size_t count)
+    {
+        calls++;
+        return count;
+    }, [&]
+    {
+        underflow = true;
+    });
+
+    EXPECT_EQ(consumed, 0);
+    EXPECT_EQ(calls, 0);
+    EXPECT_TRUE(underflow);
+}
+
+TEST(RealTimeQueue, DequeueBatchMaxItems1)
+{
+    QueueType queue{8};
+    std::vector<int> values;
+
+    enqueueValues(queue, 0, 5);
+
+    auto consumed = queue.dequeueBatch(3, [&](int* items, std::size_t count)
+    {
+        values.insert(values.end(), items, items + count);
+        return count;
+    }, [] {});
+
+    EXPECT_EQ(consumed, 3);
+    EXPECT_THAT(values, ::testing::ElementsAre(0, 1, 2));
+
+    // the rest is drained with one call
+    consumed = queue.dequeueBatch(8, [&](int* items, std::size_t count)
+    {
+        values.insert(values.end(), items, items + count);
+        return count;
+    }, [] {});
+
+    EXPECT_EQ(consumed, 2);
+    EXPECT_THAT(values, ::testing::ElementsAre(0, 1, 2, 3, 4));
+}
+
+TEST(RealTimeQueue, DequeueBatchWrapAround1)
+{
+    QueueType queue{8};
+    std::vector<std::size_t> spans;
+    std::vector<int> values;
+
+    // moving head and tail close to the end of the buffer
+    enqueueValues(queue, 0, 6);
+    queue.dequeueBatch(6, [](int*, std::size_t count)
+    {
+        return count;
+    }, [] {});
+    enqueueValues(queue, 6, 11);
+
+    auto consumed = queue.dequeueBatch(8, [&](int* items, std::size_t count)
+    {
+        spans.push_back(count);
+        values.insert(values.end(), items, items + count);
+        return count;
+    }, [] {});
+
+    EXPECT_EQ(consumed, 5);
+    EXPECT_THAT(spans, ::testing::ElementsAre(2, 3));
+    EXPECT_THAT(values, ::testing::ElementsAre(6, 7, 8, 9, 10));
+}
+
+TEST(RealTimeQueue, DequeueBatchPartial1)
+{
+    QueueType queue{8};
+    std::vector<int> values;
+
+    enqueueValues(queue, 0, 4);
+
+    // elements which were not consumed remain in the queue
+    auto consumed = queue.dequeueBatch(4, [&](int* items, std::size_t)
+    {
+        values.push_back(items[0]);
+        return 1;
+    }, [] {});
+
+    EXPECT_EQ(consumed, 1);
+
+    queue.dequeue([&](int& value)
+    {
+        values.push_back(value);
+        return true;
+    }, [] {});
+
+    EXPECT_THAT(values, ::testing::ElementsAre(0, 1));
+}
+
+TEST(RealTimeQueue, DequeueBatchConcurrent1)
+{
+    QueueType queue{16};
+    std::vector<int> values;
+    auto total = 100000;
+
+    std::thread producer{[&]
+    {
+        for (auto i = 0; i < total;)
+        {
+            queue.enqueue([&](int& value)
+            {
+                value = i++;
+                return true;
+            }, []
+            {
+                std::this_thread::yield();
+            });
+        }
+    }};
+
+    while (values.size() < static_cast<std::size_t>(total))
+    {
+        queue.dequeueBatch(total, [&](int* items, std::size_t count)
+        {
+            values.insert(values.end(), items, items + count);
+            return count;
+        }, []
+        {
+            std::this_thread::yield();
+        });
+    }
+    producer.join();
+
+    for (auto i = 0; i < total; i++)
+    {
+        ASSERT_EQ(values[i], i);
+    }
+}
@@ -0,0 +1,34 @@
+/*
+ * Copyright 2017, Andrej Kislovskij
+ *
+ * This is PUBLIC DOMAIN software so use at your own risk as it comes
+ * with no warranties. This code is yours to share, use and modify without
+ * any restrictions or obligations.
+ *
+ * For more information see conwrap/LICENSE or refer refer to http://unlicense.org
+ *
+ * Author: gimesketvirtadieni at gmail dot com (Andrej Kislovskij)
+ */
+
+#pragma once
+
+#include <cstddef>  // std::size_t
+#include <cstdint>  // std::u..._t types
+#include <random>
+#include <vector>
+
+
+// creates random S32_LE samples; the same size always produces the same samples
+inline auto createSamples(std::size_t size)
+{
+	std::mt19937                                generator{static_cast<std::mt19937::result_type>(size)};
+	std::uniform_int_distribution<unsigned int> distribution{0, 255};
+	std::vector<unsigned char>                  samples(size * sizeof(std::int32_t));
+
+	for (auto& value : samples)
+	{
+		value = static_cast<unsigned char>(distribution(generator));
+	}
+
+	return samples;
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2017, Andrej Kislovskij
+ *
+ * This is PUBLIC DOMAIN software so use at your own risk as it comes
+ * with no warranties. This code is yours to share, use and modify without
+ * any restrictions or obligations.
+ *
+ * For more information see conwrap/LICENSE or refer refer to http://unlicense.org
+ *
+ * Author: gimesketvirtadieni at gmail dot com (Andrej Kislovskij)
+ */
+
+#include <array>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "slim/util/StateMachine.hpp"
+
+
+class Door
+{
+	public:
+		enum Event
+		{
+			OpenEvent,
+			CloseEvent,
+			LockEvent,
+		};
+
+		enum State
+		{
+			OpenedState,
+			ClosedState,
+			LockedState,
+		};
+
+		static constexpr auto getTransitions()
+		{
+			return std::array<slim::util::Transition<Door, Event, State>, 4>
+			{{
+				{OpenEvent,  ClosedState, OpenedState, &Door::onOpen, &Door::isUnlockable},
+				{CloseEvent, OpenedState, ClosedState, nullptr,       nullptr},
+				{LockEvent,  ClosedState, LockedState, nullptr,       nullptr},
+				{LockEvent,  ClosedState, OpenedState, nullptr,       nullptr},
+			}};
+		}
+
+		bool isUnlockable()
+		{
+			return unlockable;
+		}
+
+		void onOpen()
+		{
+			opened++;
+		}
+
+		bool                                         unlockable{true};
+		int                                          opened{0};
+		slim::util::StateMachine<Door, Event, State> stateMachine{*this, ClosedState};
+};
+
+
+TEST(StateMachine, Transition1)
+{
+	Door door;
+	auto errors{0};
+
+	EXPECT_TRUE(door.stateMachine.processEvent(Door::OpenEvent, [&](auto, auto) {errors++;}));
+	EXPECT_EQ(door.stateMachine.state, Door::OpenedState);
+	EXPECT_EQ(door.opened, 1);
+	EXPECT_EQ(errors, 0);
+}
+
+TEST(StateMachine, Transition2)
+{
+	Door door;
+	auto errors{0};
+
+	// guard prevents transition, which is not an error
+	door.unlockable = false;
+	EXPECT_FALSE(door.stateMachine.processEvent(Door::OpenEvent, [&](auto, auto) {errors++;}));
+	EXPECT_EQ(door.stateMachine.state, Door::ClosedState);
+	EXPECT_EQ(door.opened, 0);
+	EXPECT_EQ(errors, 0);
+}
+
+TEST(StateMachine, Transition3)
+{
+	Door door;
+	auto errors{0};
+
+	// there is no transition defined for Open event in Opened state
+	door.stateMachine.processEvent(Door::OpenEvent, [&](auto, auto) {errors++;});
+	EXPECT_FALSE(door.stateMachine.processEvent(Door::OpenEvent, [&](auto, auto) {errors++;}));
+	EXPECT_EQ(door.stateMachine.state, Door::OpenedState);
+	EXPECT_EQ(errors, 1);
+}
+
+TEST(StateMachine, Transition4)
+{
+	Door door;
+	auto errors{0};
+
+	// the first transition defined for a state / event pair wins
+	EXPECT_TRUE(door.stateMachine.processEvent(Door::LockEvent, [&](auto, auto) {errors++;}));
+	EXPECT_EQ(door.stateMachine.state, Door::LockedState);
+
+	// there are no transitions from Locked state
+	EXPECT_FALSE(door.stateMachine.processEvent(Door::CloseEvent, [&](auto, auto) {errors++;}));
+	EXPECT_EQ(errors, 1);
+}
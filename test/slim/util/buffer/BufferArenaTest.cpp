@@ -0,0 +1,146 @@
+/*
+ * Copyright 2017, Andrej Kislovskij
+ *
+ * This is PUBLIC DOMAIN software so use at your own risk as it comes
+ * with no warranties. This code is yours to share, use and modify without
+ * any restrictions or obligations.
+ *
+ * For more information see conwrap/LICENSE or refer refer to http://unlicense.org
+ *
+ * Author: gimesketvirtadieni at gmail dot com (Andrej Kislovskij)
+ */
+
+#include <atomic>
+#include <set>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "slim/util/buffer/BufferArenaTest.hpp"
+
+
+TEST_P(BufferArenaTestFixture, Constructor1)
+{
+    std::size_t poolSize = GetParam();
+    std::size_t bufferSize = 1;
+    BufferArenaTest<int> bufferArena{poolSize, bufferSize};
+
+    EXPECT_EQ(bufferArena.getSize(), poolSize);
+    EXPECT_EQ(bufferArena.getAvailableSize(), poolSize);
+    EXPECT_EQ(bufferArena.getBufferSize(), bufferSize);
+}
+
+TEST(BufferArenaTest, Constructor2)
+{
+    EXPECT_FALSE(std::is_move_constructible<BufferArenaTestFixture::BufferArenaTest<int>>::value);
+    EXPECT_FALSE(std::is_trivially_copyable<BufferArenaTestFixture::BufferArenaTest<int>::ArenaBufferType>::value);
+}
+
+TEST_P(BufferArenaTestFixture, Allocate1)
+{
+    std::size_t poolSize = GetParam();
+    std::size_t bufferSize = 2;
+    BufferArenaTest<int> bufferArena{poolSize, bufferSize};
+    std::vector<BufferArenaTest<int>::ArenaBufferType> allocatedBuffers;
+
+    // repeating this part 3 times
+    for (auto i = 0u; i < 3; i++)
+    {
+        allocatedBuffers.clear();
+
+        // exhausting arena
+        EXPECT_EQ(bufferArena.getAvailableSize(), poolSize);
+        for (auto j = 0u; j < poolSize; j++)
+        {
+            auto allocatedBuffer = bufferArena.allocate();
+            EXPECT_NE(allocatedBuffer.getData(), nullptr);
+            EXPECT_EQ(allocatedBuffer.getSize(), bufferSize);
+
+            allocatedBuffers.push_back(std::move(allocatedBuffer));
+        }
+        EXPECT_EQ(bufferArena.getAvailableSize(), 0);
+
+        auto allocatedBuffer = bufferArena.allocate();
+        EXPECT_EQ(allocatedBuffer.getData(), nullptr);
+        EXPECT_EQ(allocatedBuffer.getSize(), 0);
+    }
+}
+
+TEST(BufferArenaTest, Allocate2)
+{
+    std::size_t poolSize = 3;
+    std::size_t bufferSize = 2;
+    BufferArenaTestFixture::BufferArenaTest<int> bufferArena{poolSize, bufferSize};
+    std::set<int*> pointers;
+
+    // buffers must not overlap
+    std::vector<BufferArenaTestFixture::BufferArenaTest<int>::ArenaBufferType> allocatedBuffers;
+    for (auto i = 0u; i < poolSize; i++)
+    {
+        allocatedBuffers.push_back(bufferArena.allocate());
+        allocatedBuffers.back().getData()[0] = i;
+        allocatedBuffers.back().getData()[1] = i;
+        pointers.insert(allocatedBuffers.back().getData());
+    }
+    EXPECT_EQ(pointers.size(), poolSize);
+    for (auto i = 0u; i < poolSize; i++)
+    {
+        EXPECT_EQ(allocatedBuffers[i].getData()[0], i);
+        EXPECT_EQ(allocatedBuffers[i].getData()[1], i);
+    }
+}
+
+TEST(BufferArenaTest, Allocate3)
+{
+    BufferArenaTestFixture::BufferArenaTest<int> bufferArena{2, 1};
+    auto allocatedBuffer1 = bufferArena.allocate();
+    auto allocatedBuffer2 = bufferArena.allocate();
+    auto* data = allocatedBuffer1.getData();
+
+    // the most recently released buffer is reused first
+    allocatedBuffer1 = BufferArenaTestFixture::BufferArenaTest<int>::ArenaBufferType{};
+    EXPECT_EQ(bufferArena.getAvailableSize(), 1);
+    EXPECT_EQ(allocatedBuffer1.getData(), nullptr);
+
+    allocatedBuffer1 = bufferArena.allocate();
+    EXPECT_EQ(bufferArena.getAvailableSize(), 0);
+    EXPECT_EQ(allocatedBuffer1.getData(), data);
+}
+
+TEST(BufferArenaTest, Allocate4)
+{
+    std::size_t poolSize = 8;
+    BufferArenaTestFixture::BufferArenaTest<int> bufferArena{poolSize, 1};
+    std::atomic<bool> failed{false};
+    std::vector<std::thread> threads;
+
+    // every thread owns a buffer exclusively between allocation and release
+    for (auto i = 0; i < 4; i++)
+    {
+        threads.emplace_back([&, i]
+        {
+            for (auto j = 0; j < 10000; j++)
+            {
+                auto allocatedBuffer = bufferArena.allocate();
+                if (allocatedBuffer.getData())
+                {
+                    allocatedBuffer.getData()[0] = i;
+                    std::this_thread::yield();
+                    if (allocatedBuffer.getData()[0] != i)
+                    {
+                        failed = true;
+                    }
+                }
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    EXPECT_FALSE(failed);
+    EXPECT_EQ(bufferArena.getAvailableSize(), poolSize);
+}
+
+INSTANTIATE_TEST_SUITE_P(BufferArenaInstantiation, BufferArenaTestFixture, testing::Values(0, 1, 2, 3));
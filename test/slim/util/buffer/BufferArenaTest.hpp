@@ -0,0 +1,28 @@
+/*
+ * Copyright 2017, Andrej Kislovskij
+ *
+ * This is PUBLIC DOMAIN software so use at your own risk as it comes
+ * with no warranties. This code is yours to share, use and modify without
+ * any restrictions or obligations.
+ *
+ * For more information see conwrap/LICENSE or refer refer to http://unlicense.org
+ *
+ * Author: gimesketvirtadieni at gmail dot com (Andrej Kislovskij)
+ */
+
+#pragma once
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "slim/util/buffer/BufferArena.hpp"
+
+
+struct BufferArenaTestFixture : public ::testing::TestWithParam<std::size_t>
+{
+	template
+    <
+		typename ElementType
+	>
+	using BufferArenaTest = slim::util::buffer::BufferArena<ElementType>;
+};
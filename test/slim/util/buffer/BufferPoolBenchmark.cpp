@@ -0,0 +1,123 @@
+/*
+ * Copyright 2017, Andrej Kislovskij
+ *
+ * This is PUBLIC DOMAIN software so use at your own risk as it comes
+ * with no warranties. This code is yours to share, use and modify without
+ * any restrictions or obligations.
+ *
+ * For more information see conwrap/LICENSE or refer refer to http://unlicense.org
+ *
+ * Author: gimesketvirtadieni at gmail dot com (Andrej Kislovskij)
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>  // std::size_t
+#include <functional>
+#include <gtest/gtest.h>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "slim/util/buffer/BufferPool.hpp"
+#include "slim/util/buffer/HeapBuffer.hpp"
+
+
+// benchmarks are disabled by default; use --gtest_also_run_disabled_tests --gtest_filter=*Benchmark* to run them
+namespace
+{
+    // the previous pool implementation with a linear search and std::function deleter is kept as a baseline
+    template
+    <
+        typename ElementType
+    >
+    class LinearBufferPool
+    {
+        public:
+            using StorageType = std::unique_ptr<ElementType[], std::function<void(ElementType*)>>;
+
+            inline explicit LinearBufferPool(std::size_t poolSize, std::size_t bufferSize)
+            {
+                for (std::size_t i = 0; i < poolSize; i++)
+                {
+                    buffers.emplace_back(BufferWrapper{slim::util::buffer::HeapBuffer<ElementType>{bufferSize}, true});
+                }
+            }
+
+            inline auto allocate()
+            {
+                for (std::size_t i = 0; i < buffers.size(); i++)
+                {
+                    if (buffers[i].free)
+                    {
+                        buffers[i].free = false;
+                        return StorageType{buffers[i].buffer.getData(), [&buffers = buffers, index = i](auto*)
+                        {
+                            buffers[index].free = true;
+                        }};
+                    }
+                }
+
+                return StorageType{};
+            }
+
+            inline auto getAvailableSize() const
+            {
+                return static_cast<std::size_t>(std::count_if(buffers.begin(), buffers.end(), [](const auto& buffer)
+                {
+                    return buffer.free;
+                }));
+            }
+
+        private:
+            struct BufferWrapper
+            {
+                slim::util::buffer::HeapBuffer<ElementType> buffer;
+                bool                                        free;
+            };
+
+            std::vector<BufferWrapper> buffers;
+    };
+
+    // allocates a window of buffers, checking availability on every allocation the way sessions used to do it
+    template <typename PoolType, typename BufferType>
+    auto run(PoolType& pool, std::size_t poolSize, std::size_t iterations)
+    {
+        std::vector<BufferType> allocated;
+        allocated.reserve(poolSize);
+
+        auto start{std::chrono::steady_clock::now()};
+        for (std::size_t i = 0; i < iterations; i++)
+        {
+            while (pool.getAvailableSize() > 0)
+            {
+                allocated.push_back(pool.allocate());
+            }
+            allocated.clear();
+        }
+
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    }
+}
+
+
+TEST(BufferPoolBenchmark, DISABLED_AllocateRelease)
+{
+    for (std::size_t poolSize : {16, 64, 256})
+    {
+        std::size_t iterations{1000000 / poolSize};
+        std::size_t bufferSize{4096};
+
+        LinearBufferPool<unsigned char> linearPool{poolSize, bufferSize};
+        slim::util::buffer::BufferPool<unsigned char> freeListPool{poolSize, bufferSize};
+
+        auto linearTime{run<decltype(linearPool), typename LinearBufferPool<unsigned char>::StorageType>(linearPool, poolSize, iterations)};
+        auto freeListTime{run<decltype(freeListPool), typename slim::util::buffer::BufferPool<unsigned char>::PooledBufferType>(freeListPool, poolSize, iterations)};
+
+        std::cout << "pool size=" << poolSize
+                  << " linear=" << linearTime.count() << "us"
+                  << " free-list=" << freeListTime.count() << "us" << std::endl;
+
+        EXPECT_EQ(freeListPool.getAvailableSize(), poolSize);
+    }
+}
@@ -10,7 +10,9 @@
  * Author: gimesketvirtadieni at gmail dot com (Andrej Kislovskij)
  */
 
+#include <thread>
 #include <type_traits>
+#include <vector>
 
 #include "slim/util/buffer/BufferPoolTest.hpp"
 
@@ -128,4 +130,26 @@ TEST(BufferPoolTest, Allocate3)
     EXPECT_EQ(allocatedBuffer.getData(), nullptr);
 }
 
+TEST(BufferPoolTest, Allocate4)
+{
+    std::size_t poolSize = 4;
+    BufferPoolTestFixture::BufferPoolTest<int> bufferPool{poolSize, 1};
+    std::vector<BufferPoolTestFixture::BufferPoolTest<int>::PooledBufferType> allocatedBuffers;
+
+    for (auto i = 0u; i < poolSize; i++)
+    {
+        allocatedBuffers.push_back(bufferPool.allocate());
+    }
+    EXPECT_EQ(bufferPool.getAvailableSize(), 0);
+
+    // buffers may be released from a different thread
+    std::thread thread{[&]
+    {
+        allocatedBuffers.clear();
+    }};
+    thread.join();
+
+    EXPECT_EQ(bufferPool.getAvailableSize(), poolSize);
+}
+
 INSTANTIATE_TEST_SUITE_P(BufferPoolInstantiation, BufferPoolTestFixture, testing::Values(0, 1, 2, 3));
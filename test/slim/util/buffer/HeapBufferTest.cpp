@@ -10,6 +10,7 @@
  * Author: gimesketvirtadieni at gmail dot com (Andrej Kislovskij)
  */
 
+#include <cstdint>  // std::uintptr_t
 #include <type_traits>
 
 #include "slim/util/buffer/HeapBufferTest.hpp"
@@ -81,4 +82,14 @@ TEST_P(HeapBufferTestFixture, getElement2)
 	validateState(buffer, samples);
 }
 
+TEST_P(HeapBufferTestFixture, AlignedStorage1)
+{
+	std::size_t size = GetParam();
+	slim::util::buffer::HeapBuffer<int, slim::util::buffer::AlignedHeapBufferStorage> buffer{size};
+
+	EXPECT_EQ(buffer.getSize(), size);
+	EXPECT_NE(buffer.getData(), nullptr);
+	EXPECT_EQ(reinterpret_cast<std::uintptr_t>(buffer.getData()) % slim::util::buffer::AlignedHeapBufferStorage<int>::alignment, 0);
+}
+
 INSTANTIATE_TEST_SUITE_P(HeapBufferInstantiation, HeapBufferTestFixture, testing::Values(0, 1, 2, 3));
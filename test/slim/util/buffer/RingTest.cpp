@@ -10,7 +10,9 @@
  * Author: gimesketvirtadieni at gmail dot com (Andrej Kislovskij)
  */
 
+#include <algorithm>
 #include <type_traits>
+#include <vector>
 
 #include "slim/util/buffer/RingTest.hpp"
 
@@ -92,6 +94,75 @@ TEST_P(RingTestFixture, Pop3)
 	}
 }
 
+TEST_P(RingTestFixture, Pop4)
+{
+	std::size_t capacity = GetParam();
+	RingTest<int> ring{capacity};
+	std::vector<int> samples;
+
+	for (int i = 0; i < GetParam(); i++)
+	{
+		ring.push(i);
+		samples.push_back(i);
+	}
+	ring.pop(2);
+	samples.erase(samples.begin(), samples.begin() + std::min<std::size_t>(2, samples.size()));
+
+	validateState(ring, capacity, samples);
+}
+
+TEST_P(RingTestFixture, PushBulk1)
+{
+	std::size_t capacity = GetParam();
+	RingTest<int> ring1{capacity};
+	RingTest<int> ring2{capacity};
+	std::vector<int> items{1, 2, 3, 4, 5};
+
+	// bulk push must be equivalent to pushing items one by one, including wrapping around and overwriting
+	for (auto offset : {0, 1, 2})
+	{
+		for (auto i{0}; i < offset; i++)
+		{
+			ring1.push(-i);
+			ring2.push(-i);
+		}
+		ring1.push(items.data(), items.size());
+		for (auto& item : items)
+		{
+			ring2.push(item);
+		}
+
+		std::vector<int> samples;
+		for (auto i{0u}; i < ring2.getSize(); i++)
+		{
+			samples.push_back(ring2[i]);
+		}
+		validateState(ring1, capacity, samples);
+	}
+}
+
+TEST(RingTest, Copy1)
+{
+	std::size_t capacity = 4;
+	RingTestFixture::RingTest<int> ring{capacity};
+	int items[4] = {0, 0, 0, 0};
+
+	// making data wrap around the end of the storage
+	ring.push(1);
+	ring.push(2);
+	ring.push(3);
+	ring.pop();
+	ring.pop();
+	ring.push(4);
+	ring.push(5);
+	ring.copy(0, items, 3);
+
+	EXPECT_EQ(items[0], 3);
+	EXPECT_EQ(items[1], 4);
+	EXPECT_EQ(items[2], 5);
+	EXPECT_EQ(items[3], 0);
+}
+
 TEST(RingTest, Push1)
 {
 	std::size_t capacity = 1;
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2017, Andrej Kislovskij
+ *
+ * This is PUBLIC DOMAIN software so use at your own risk as it comes
+ * with no warranties. This code is yours to share, use and modify without
+ * any restrictions or obligations.
+ *
+ * For more information see conwrap/LICENSE or refer refer to http://unlicense.org
+ *
+ * Author: gimesketvirtadieni at gmail dot com (Andrej Kislovskij)
+ */
+
+#include <cstddef>  // std::size_t
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "slim/util/SamplesHelper.hpp"
+#include "slim/wave/Kernels.hpp"
+
+
+TEST(WaveKernels, PackSamples24)
+{
+	for (std::size_t size = 0; size < 40; size++)
+	{
+		auto samples{createSamples(size)};
+
+		// guard bytes are used to validate that nothing is written past the end of the destination buffer
+		std::vector<unsigned char> bufferScalar(size * 3 + 4, 0xAA);
+		std::vector<unsigned char> bufferVector(size * 3 + 4, 0xAA);
+
+		slim::wave::kernels::packSamples24Scalar(samples.data(), bufferScalar.data(), size);
+		slim::wave::kernels::packSamples24(samples.data(), bufferVector.data(), size);
+
+		EXPECT_EQ(bufferScalar, bufferVector);
+		for (std::size_t i = size * 3; i < bufferVector.size(); i++)
+		{
+			EXPECT_EQ(bufferVector[i], 0xAA);
+		}
+	}
+}
+
+TEST(WaveKernels, PackSamples16)
+{
+	for (std::size_t size = 0; size < 40; size++)
+	{
+		auto samples{createSamples(size)};
+		std::vector<unsigned char> bufferScalar(size * 2 + 4, 0xAA);
+		std::vector<unsigned char> bufferVector(size * 2 + 4, 0xAA);
+
+		slim::wave::kernels::packSamples16Scalar(samples.data(), bufferScalar.data(), size);
+		slim::wave::kernels::packSamples16(samples.data(), bufferVector.data(), size);
+
+		EXPECT_EQ(bufferScalar, bufferVector);
+		for (std::size_t i = size * 2; i < bufferVector.size(); i++)
+		{
+			EXPECT_EQ(bufferVector[i], 0xAA);
+		}
+	}
+}
+
+TEST(WaveKernels, PackSamples1)
+{
+	// S32_LE samples: 0x7FFFFF00, 0x80000000
+	std::vector<unsigned char> samples{0x00, 0xFF, 0xFF, 0x7F, 0x00, 0x00, 0x00, 0x80};
+	std::vector<unsigned char> buffer24(6, 0);
+	std::vector<unsigned char> buffer16(4, 0);
+
+	slim::wave::kernels::packSamples24(samples.data(), buffer24.data(), 2);
+	slim::wave::kernels::packSamples16(samples.data(), buffer16.data(), 2);
+
+	EXPECT_EQ(buffer24, (std::vector<unsigned char>{0xFF, 0xFF, 0x7F, 0x00, 0x00, 0x80}));
+	EXPECT_EQ(buffer16, (std::vector<unsigned char>{0xFF, 0x7F, 0x00, 0x80}));
+}